@@ -332,6 +332,25 @@ TEST (block, confirm_req_serialization)
 	ASSERT_EQ (*req.block, *req2.block);
 }
 
+TEST (block, confirm_req_hash_serialization)
+{
+	std::vector<std::pair<rai::block_hash, rai::block_hash>> roots_hashes{ { 1, 2 }, { 3, 4 } };
+	rai::confirm_req req (roots_hashes);
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		req.serialize (stream);
+	}
+	auto error (false);
+	rai::bufferstream stream2 (bytes.data (), bytes.size ());
+	rai::message_header header (error, stream2);
+	rai::confirm_req req2 (error, stream2, header);
+	ASSERT_FALSE (error);
+	ASSERT_EQ (req, req2);
+	ASSERT_EQ (nullptr, req2.block);
+	ASSERT_EQ (roots_hashes, req2.roots_hashes);
+}
+
 TEST (state_block, serialization)
 {
 	rai::keypair key1;
@@ -390,23 +409,137 @@ TEST (state_block, hashing)
 	rai::state_block block (key.pub, 0, key.pub, 0, 0, key.prv, key.pub, 0);
 	auto hash (block.hash ());
 	block.hashables.account.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.account.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.previous.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.previous.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.representative.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.representative.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.balance.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.balance.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.link.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.link.bytes[0] ^= 0x1;
+	block.refresh ();
 	ASSERT_EQ (hash, block.hash ());
 }
+
+TEST (block_uniquer, null)
+{
+	rai::block_uniquer uniquer;
+	ASSERT_EQ (nullptr, uniquer.unique (nullptr));
+}
+
+TEST (block_uniquer, single)
+{
+	rai::keypair key;
+	auto block1 (std::make_shared<rai::state_block> (0, 0, 0, 0, 0, key.prv, key.pub, 0));
+	auto block2 (std::make_shared<rai::state_block> (*block1));
+	ASSERT_NE (block1, block2);
+	ASSERT_EQ (*block1, *block2);
+	std::weak_ptr<rai::state_block> block3 (block2);
+	ASSERT_NE (nullptr, block3.lock ());
+	rai::block_uniquer uniquer;
+	auto block4 (uniquer.unique (block1));
+	ASSERT_EQ (block1, block4);
+	auto block5 (uniquer.unique (block2));
+	ASSERT_EQ (block1, block5);
+	block2.reset ();
+	ASSERT_EQ (nullptr, block3.lock ());
+}
+
+// A copy with a different signature must not resolve to the live block
+TEST (block_uniquer, signature)
+{
+	rai::keypair key;
+	auto block1 (std::make_shared<rai::state_block> (0, 0, 0, 0, 0, key.prv, key.pub, 0));
+	auto block2 (std::make_shared<rai::state_block> (*block1));
+	block2->signature_set (rai::uint512_union (1));
+	ASSERT_EQ (block1->hash (), block2->hash ());
+	ASSERT_NE (block1->full_hash (), block2->full_hash ());
+	rai::block_uniquer uniquer;
+	ASSERT_EQ (block2, uniquer.unique (block2));
+	ASSERT_EQ (block1, uniquer.unique (block1));
+	ASSERT_EQ (2, uniquer.size ());
+}
+
+TEST (block_uniquer, cleanup)
+{
+	rai::keypair key;
+	auto block1 (std::make_shared<rai::state_block> (0, 0, 0, 0, 0, key.prv, key.pub, 0));
+	auto block2 (std::make_shared<rai::state_block> (0, 0, 0, 0, 0, key.prv, key.pub, 1));
+	rai::block_uniquer uniquer;
+	auto block3 (uniquer.unique (block1));
+	auto block4 (uniquer.unique (block2));
+	block2.reset ();
+	block4.reset ();
+	ASSERT_EQ (2, uniquer.size ());
+	auto iterations (0);
+	while (uniquer.size () == 2)
+	{
+		auto block5 (uniquer.unique (block1));
+		ASSERT_LT (iterations++, 200);
+	}
+	ASSERT_EQ (1, uniquer.size ());
+}
+
+TEST (block_uniquer, deserialize)
+{
+	rai::keypair key;
+	rai::state_block block1 (0, 0, 0, 0, 0, key.prv, key.pub, 0);
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		block1.serialize (stream);
+	}
+	rai::block_uniquer uniquer;
+	rai::bufferstream stream1 (bytes.data (), bytes.size ());
+	auto block2 (rai::deserialize_block_shared (stream1, rai::block_type::state, &uniquer));
+	rai::bufferstream stream2 (bytes.data (), bytes.size ());
+	auto block3 (rai::deserialize_block_shared (stream2, rai::block_type::state, &uniquer));
+	ASSERT_NE (nullptr, block2);
+	ASSERT_EQ (block2, block3);
+}
+
+TEST (block, hash_cache)
+{
+	rai::keypair key;
+	rai::send_block block1 (0, 1, 2, key.prv, key.pub, 3);
+	auto hash (block1.hash ());
+	rai::send_block block2 (block1);
+	ASSERT_EQ (hash, block2.hash ());
+	block1.signature_set (rai::signature (4));
+	block1.block_work_set (5);
+	ASSERT_EQ (hash, block1.hash ());
+	block1.hashables.previous = 6;
+	block1.refresh ();
+	ASSERT_NE (hash, block1.hash ());
+	block2 = block1;
+	ASSERT_EQ (block1.hash (), block2.hash ());
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		block1.serialize (stream);
+	}
+	rai::send_block block3 (0, 1, 2, key.prv, key.pub, 3);
+	ASSERT_EQ (hash, block3.hash ());
+	rai::bufferstream stream (bytes.data (), bytes.size ());
+	ASSERT_FALSE (block3.deserialize (stream));
+	ASSERT_EQ (block1.hash (), block3.hash ());
+}
@@ -68,6 +68,7 @@ TEST (block_store, add_two_items)
 	ASSERT_EQ (nullptr, latest1);
 	rai::open_block block2 (0, 1, 3, rai::keypair ().prv, 0, 0);
 	block2.hashables.account = 3;
+	block2.refresh ();
 	rai::uint256_union hash2 (block2.hash ());
 	block2.signature = rai::sign_message (key1.prv, key1.pub, hash2);
 	auto latest2 (store.block_get (transaction, hash2));
@@ -177,6 +178,49 @@ TEST (representation, changes)
 	ASSERT_EQ (2, store.representation_get (transaction, key1.pub));
 }
 
+TEST (representation, reopen)
+{
+	auto path (rai::unique_path ());
+	rai::keypair key1;
+	rai::keypair key2;
+	{
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.representation_put (transaction, key1.pub, 100);
+		store.representation_put (transaction, key2.pub, 200);
+		store.representation_put (transaction, key2.pub, 0);
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+	ASSERT_EQ (0, store.representation_get (transaction, key2.pub));
+	ASSERT_EQ (1, std::atomic_load (&store.representation_cache)->size ());
+}
+
+TEST (representation, commit)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	rai::keypair key1;
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.representation_put (transaction, key1.pub, 100);
+		ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+		// Readers outside the write transaction don't see the weight before it commits
+		rai::transaction read (store.environment, nullptr, false);
+		ASSERT_EQ (0, store.representation_get (read, key1.pub));
+		ASSERT_TRUE (std::atomic_load (&store.representation_cache)->empty ());
+	}
+	rai::transaction read (store.environment, nullptr, false);
+	ASSERT_EQ (100, store.representation_get (read, key1.pub));
+	ASSERT_TRUE (store.representation_staged.empty ());
+}
+
 TEST (bootstrap, simple)
 {
 	bool init (false);
@@ -227,6 +271,33 @@ TEST (unchecked, double_put)
 	ASSERT_EQ (block3.size (), 1);
 }
 
+TEST (unchecked, limits)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	store.unchecked_cache_max = 1;
+	store.unchecked_max = 2;
+	auto block1 (std::make_shared<rai::send_block> (4, 1, 2, rai::keypair ().prv, 4, 5));
+	auto block2 (std::make_shared<rai::send_block> (5, 1, 2, rai::keypair ().prv, 4, 5));
+	auto block3 (std::make_shared<rai::send_block> (6, 1, 2, rai::keypair ().prv, 4, 5));
+	rai::transaction transaction (store.environment, nullptr, true);
+	ASSERT_FALSE (store.unchecked_put (transaction, block1->previous (), block1));
+	// Cache is full, the second entry goes straight to the table
+	ASSERT_FALSE (store.unchecked_put (transaction, block2->previous (), block2));
+	ASSERT_EQ (1, store.unchecked_cache.size ());
+	ASSERT_EQ (2, store.unchecked_count (transaction));
+	ASSERT_EQ (1, store.unchecked_get (transaction, block2->previous ()).size ());
+	// Table is full
+	ASSERT_TRUE (store.unchecked_put (transaction, block3->previous (), block3));
+	ASSERT_TRUE (store.unchecked_get (transaction, block3->previous ()).empty ());
+	store.unchecked_del (transaction, block1->previous (), *block1);
+	ASSERT_FALSE (store.unchecked_put (transaction, block3->previous (), block3));
+	store.flush (transaction);
+	ASSERT_EQ (2, store.unchecked_count (transaction));
+	ASSERT_TRUE (store.unchecked_cache.empty ());
+}
+
 TEST (checksum, simple)
 {
 	bool init (false);
@@ -290,9 +361,10 @@ TEST (block_store, one_bootstrap)
 	auto begin (store.unchecked_begin (transaction));
 	auto end (store.unchecked_end ());
 	ASSERT_NE (end, begin);
-	rai::uint256_union hash1 (begin->first);
-	ASSERT_EQ (block1->hash (), hash1);
-	auto blocks (store.unchecked_get (transaction, rai::block_hash (begin->first)));
+	rai::unchecked_key key1 (begin->first);
+	ASSERT_EQ (block1->hash (), key1.previous);
+	ASSERT_EQ (block1->hash (), key1.hash);
+	auto blocks (store.unchecked_get (transaction, key1.previous));
 	ASSERT_EQ (1, blocks.size ());
 	auto block2 (blocks[0]);
 	ASSERT_EQ (*block1, *block2);
@@ -353,6 +425,7 @@ TEST (block_store, two_block)
 	ASSERT_TRUE (!init);
 	rai::open_block block1 (0, 1, 1, rai::keypair ().prv, 0, 0);
 	block1.hashables.account = 1;
+	block1.refresh ();
 	std::vector<rai::block_hash> hashes;
 	std::vector<rai::open_block> blocks;
 	hashes.push_back (block1.hash ());
@@ -552,6 +625,26 @@ TEST (block_store, block_count)
 	ASSERT_EQ (1, store.block_count (rai::transaction (store.environment, nullptr, false)).sum ());
 }
 
+TEST (block_store, block_count_staged)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::open_block block1 (0, 1, 0, rai::keypair ().prv, 0, 0);
+	rai::open_block block2 (1, 1, 0, rai::keypair ().prv, 0, 0);
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.block_put (transaction, block1.hash (), block1);
+		store.block_put (transaction, block2.hash (), block2);
+		store.block_del (transaction, block1.hash ());
+		ASSERT_EQ (1, store.block_count (transaction).open);
+		// Counts are written once the transaction commits
+		rai::transaction read (store.environment, nullptr, false);
+		ASSERT_EQ (0, store.block_count (read).sum ());
+	}
+	ASSERT_EQ (1, store.block_count (rai::transaction (store.environment, nullptr, false)).open);
+}
+
 TEST (block_store, account_count)
 {
 	bool init (false);
@@ -772,49 +865,64 @@ TEST (block_store, upgrade_v6_v7)
 	ASSERT_EQ (store.unchecked_end (), store.unchecked_begin (transaction));
 }
 
-// Databases need to be dropped in order to convert to dupsort compatible
-TEST (block_store, change_dupsort)
+// Unchecked entries used to be duplicates under their dependency, the table is dropped when upgrading to unique keys
+TEST (block_store, upgrade_v13_v14)
 {
 	auto path (rai::unique_path ());
-	bool init (false);
-	rai::block_store store (init, path);
-	rai::transaction transaction (store.environment, nullptr, true);
-	ASSERT_EQ (0, mdb_drop (transaction, store.unchecked, 1));
-	ASSERT_EQ (0, mdb_dbi_open (transaction, "unchecked", MDB_CREATE, &store.unchecked));
 	auto send1 (std::make_shared<rai::send_block> (0, 0, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
 	auto send2 (std::make_shared<rai::send_block> (1, 0, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
-	ASSERT_NE (send1->hash (), send2->hash ());
-	store.unchecked_put (transaction, send1->hash (), send1);
-	store.unchecked_put (transaction, send1->hash (), send2);
-	store.flush (transaction);
-	{
-		auto iterator1 (store.unchecked_begin (transaction));
-		++iterator1;
-		ASSERT_EQ (store.unchecked_end (), iterator1);
-	}
-	ASSERT_EQ (0, mdb_drop (transaction, store.unchecked, 0));
-	mdb_dbi_close (store.environment, store.unchecked);
-	ASSERT_EQ (0, mdb_dbi_open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &store.unchecked));
-	store.unchecked_put (transaction, send1->hash (), send1);
-	store.unchecked_put (transaction, send1->hash (), send2);
-	store.flush (transaction);
 	{
-		auto iterator1 (store.unchecked_begin (transaction));
-		++iterator1;
-		ASSERT_EQ (store.unchecked_end (), iterator1);
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		ASSERT_EQ (0, mdb_drop (transaction, store.unchecked, 1));
+		ASSERT_EQ (0, mdb_dbi_open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &store.unchecked));
+		ASSERT_EQ (0, mdb_put (transaction, store.unchecked, rai::mdb_val (send1->hash ()), rai::mdb_val (*send1), 0));
+		ASSERT_EQ (0, mdb_put (transaction, store.unchecked, rai::mdb_val (send1->hash ()), rai::mdb_val (*send2), 0));
+		store.version_put (transaction, 13);
 	}
-	ASSERT_EQ (0, mdb_drop (transaction, store.unchecked, 1));
-	ASSERT_EQ (0, mdb_dbi_open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &store.unchecked));
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, true);
+	ASSERT_LT (13, store.version_get (transaction));
+	ASSERT_EQ (0, store.unchecked_count (transaction));
 	store.unchecked_put (transaction, send1->hash (), send1);
 	store.unchecked_put (transaction, send1->hash (), send2);
 	store.flush (transaction);
+	ASSERT_EQ (2, store.unchecked_count (transaction));
+	ASSERT_EQ (2, store.unchecked_get (transaction, send1->hash ()).size ());
+}
+
+// The heights index is built from each account's chain when upgrading
+TEST (block_store, upgrade_v15_v16)
+{
+	auto path (rai::unique_path ());
+	rai::genesis genesis;
+	rai::keypair key1;
+	rai::send_block send1 (genesis.hash (), key1.pub, 50, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
 	{
-		auto iterator1 (store.unchecked_begin (transaction));
-		++iterator1;
-		ASSERT_NE (store.unchecked_end (), iterator1);
-		++iterator1;
-		ASSERT_EQ (store.unchecked_end (), iterator1);
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
+		rai::stat stats;
+		rai::ledger ledger (store, stats);
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.initialize (transaction, genesis);
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send1).code);
+		ASSERT_EQ (0, mdb_drop (transaction, store.heights, 0));
+		store.version_put (transaction, 15);
 	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_LT (15, store.version_get (transaction));
+	auto i (store.heights_begin (transaction, rai::test_genesis_key.pub, 2));
+	ASSERT_NE (store.heights_end (), i);
+	ASSERT_EQ (rai::height_key (rai::test_genesis_key.pub, 2), rai::height_key (i->first));
+	ASSERT_EQ (send1.hash (), rai::block_hash (i->second));
 }
 
 TEST (block_store, upgrade_v7_v8)
@@ -888,49 +996,165 @@ TEST (block_store, upgrade_v8_v9)
 	ASSERT_EQ (10, vote->sequence);
 }
 
-TEST (block_store, upgrade_v9_v10)
+TEST (block_store, upgrade_v11_v12)
 {
 	auto path (rai::unique_path ());
-	rai::block_hash hash (0);
+	rai::keypair key1;
+	rai::open_block block1 (0, 1, key1.pub, key1.prv, key1.pub, 0);
+	rai::state_block block2 (key1.pub, block1.hash (), 1, 2, 3, key1.prv, key1.pub, 0);
 	{
 		bool init (false);
 		rai::block_store store (init, path);
 		ASSERT_FALSE (init);
 		rai::transaction transaction (store.environment, nullptr, true);
-		rai::genesis genesis;
+		store.version_put (transaction, 11);
+		auto legacy_put = [&transaction](char const * table_a, rai::block const & block_a, rai::block_hash const & successor_a) {
+			MDB_dbi table;
+			ASSERT_EQ (0, mdb_dbi_open (transaction, table_a, MDB_CREATE, &table));
+			std::vector<uint8_t> vector;
+			{
+				rai::vectorstream stream (vector);
+				block_a.serialize (stream);
+				rai::write (stream, successor_a.bytes);
+			}
+			ASSERT_EQ (0, mdb_put (transaction, table, rai::mdb_val (block_a.hash ()), rai::mdb_val (vector.size (), vector.data ()), 0));
+		};
+		legacy_put ("open", block1, block2.hash ());
+		legacy_put ("state_v1", block2, 0);
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_LT (11, store.version_get (transaction));
+	auto block3 (store.block_get (transaction, block1.hash ()));
+	ASSERT_NE (nullptr, block3);
+	ASSERT_EQ (block1, *block3);
+	ASSERT_EQ (block2.hash (), store.block_successor (transaction, block1.hash ()));
+	auto block4 (store.block_get (transaction, block2.hash ()));
+	ASSERT_NE (nullptr, block4);
+	ASSERT_EQ (block2, *block4);
+	ASSERT_EQ (rai::epoch::epoch_0, store.block_version (transaction, block1.hash ()));
+	ASSERT_EQ (rai::epoch::epoch_1, store.block_version (transaction, block2.hash ()));
+	auto count (store.block_count (transaction));
+	ASSERT_EQ (1, count.open);
+	ASSERT_EQ (1, count.state_v1);
+	ASSERT_EQ (2, count.sum ());
+}
+
+TEST (block_store, upgrade_v12_v13)
+{
+	auto path (rai::unique_path ());
+	rai::genesis genesis;
+	rai::keypair key1;
+	rai::send_block send (genesis.hash (), key1.pub, rai::genesis_amount - rai::Gxrb_ratio, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	rai::open_block open (send.hash (), key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change (send.hash (), key1.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	{
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
 		rai::stat stats;
 		rai::ledger ledger (store, stats);
+		rai::transaction transaction (store.environment, nullptr, true);
 		store.initialize (transaction, genesis);
-		store.version_put (transaction, 9);
-		rai::account_info info;
-		store.account_get (transaction, rai::test_genesis_key.pub, info);
-		rai::keypair key0;
-		rai::uint128_t balance (rai::genesis_amount);
-		hash = info.head;
-		for (auto i (1); i < 32; ++i) // Making 31 send blocks (+ 1 open = 32 total)
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send).code);
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, open).code);
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, change).code);
+		store.version_put (transaction, 12);
+		// Rewrite each block the way version 12 stored it, with only a successor after the block
+		for (auto hash : { genesis.hash (), send.hash (), open.hash (), change.hash () })
 		{
-			balance = balance - rai::Gxrb_ratio;
-			rai::send_block block0 (hash, key0.pub, balance, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
-			ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, block0).code);
-			hash = block0.hash ();
+			auto block (store.block_get (transaction, hash));
+			ASSERT_NE (nullptr, block);
+			std::vector<uint8_t> vector;
+			{
+				rai::vectorstream stream (vector);
+				rai::write (stream, block->type ());
+				rai::write (stream, static_cast<uint8_t> (rai::epoch::epoch_0));
+				block->serialize (stream);
+				rai::write (stream, store.block_successor (transaction, hash).bytes);
+			}
+			ASSERT_EQ (0, mdb_put (transaction, store.blocks, rai::mdb_val (hash), rai::mdb_val (vector.size (), vector.data ()), 0));
+			rai::block_sideband sideband;
+			ASSERT_TRUE (store.block_sideband_get (transaction, hash, sideband));
 		}
-		rai::block_info block_info_auto; // Checking automatic block_info creation for block 32
-		store.block_info_get (transaction, hash, block_info_auto);
-		ASSERT_EQ (block_info_auto.account, rai::test_genesis_key.pub);
-		ASSERT_EQ (block_info_auto.balance.number (), balance);
-		ASSERT_EQ (0, mdb_drop (transaction, store.blocks_info, 0)); // Cleaning blocks_info subdatabase
-		bool block_info_exists (store.block_info_exists (transaction, hash));
-		ASSERT_EQ (block_info_exists, 0); // Checking if automatic block_info is deleted
 	}
 	bool init (false);
 	rai::block_store store (init, path);
 	ASSERT_FALSE (init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
 	rai::transaction transaction (store.environment, nullptr, false);
-	ASSERT_LT (9, store.version_get (transaction));
-	rai::block_info block_info;
-	store.block_info_get (transaction, hash, block_info);
-	ASSERT_EQ (block_info.account, rai::test_genesis_key.pub);
-	ASSERT_EQ (block_info.balance.number (), rai::genesis_amount - rai::Gxrb_ratio * 31);
+	ASSERT_LT (12, store.version_get (transaction));
+	rai::block_sideband sideband;
+	ASSERT_FALSE (store.block_sideband_get (transaction, send.hash (), sideband));
+	ASSERT_EQ (rai::test_genesis_key.pub, sideband.account);
+	ASSERT_EQ (2, sideband.height);
+	ASSERT_EQ (rai::genesis_amount - rai::Gxrb_ratio, sideband.balance.number ());
+	ASSERT_EQ (change.hash (), sideband.successor);
+	ASSERT_FALSE (store.block_sideband_get (transaction, change.hash (), sideband));
+	ASSERT_EQ (3, sideband.height);
+	ASSERT_EQ (rai::genesis_amount - rai::Gxrb_ratio, sideband.balance.number ());
+	ASSERT_TRUE (sideband.successor.is_zero ());
+	ASSERT_FALSE (store.block_sideband_get (transaction, open.hash (), sideband));
+	ASSERT_EQ (key1.pub, sideband.account);
+	ASSERT_EQ (1, sideband.height);
+	ASSERT_EQ (rai::Gxrb_ratio, sideband.balance.number ());
+	ASSERT_EQ (key1.pub, ledger.account (transaction, open.hash ()));
+	ASSERT_EQ (rai::Gxrb_ratio, ledger.amount (transaction, open.hash ()));
+}
+
+TEST (block_store, sideband)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::genesis genesis;
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.initialize (transaction, genesis);
+	rai::keypair key1;
+	rai::send_block send (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send).code);
+	rai::state_block open (key1.pub, 0, key1.pub, 100, send.hash (), key1.prv, key1.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, open).code);
+	rai::block_sideband sideband1;
+	ASSERT_FALSE (store.block_sideband_get (transaction, genesis.hash (), sideband1));
+	ASSERT_EQ (rai::test_genesis_key.pub, sideband1.account);
+	ASSERT_EQ (send.hash (), sideband1.successor);
+	ASSERT_EQ (1, sideband1.height);
+	rai::block_sideband sideband2;
+	auto block (store.block_get (transaction, send.hash (), &sideband2));
+	ASSERT_NE (nullptr, block);
+	ASSERT_EQ (send, *block);
+	ASSERT_EQ (rai::test_genesis_key.pub, sideband2.account);
+	ASSERT_EQ (rai::genesis_amount - 100, sideband2.balance.number ());
+	ASSERT_EQ (2, sideband2.height);
+	ASSERT_NE (0, sideband2.timestamp);
+	rai::block_sideband sideband3;
+	ASSERT_FALSE (store.block_sideband_get (transaction, open.hash (), sideband3));
+	ASSERT_EQ (key1.pub, sideband3.account);
+	ASSERT_EQ (100, sideband3.balance.number ());
+	ASSERT_EQ (1, sideband3.height);
+	ledger.rollback (transaction, send.hash ());
+	ASSERT_FALSE (store.block_sideband_get (transaction, genesis.hash (), sideband1));
+	ASSERT_TRUE (sideband1.successor.is_zero ());
+}
+
+// Blocks put without sideband report it missing rather than a zeroed account and balance
+TEST (block_store, sideband_empty)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, true);
+	rai::send_block send (0, 1, 2, rai::keypair ().prv, 4, 5);
+	store.block_put (transaction, send.hash (), send);
+	ASSERT_TRUE (store.block_exists (transaction, send.hash ()));
+	rai::block_sideband sideband;
+	ASSERT_TRUE (store.block_sideband_get (transaction, send.hash (), sideband));
 }
 
 TEST (block_store, state_block)
@@ -958,3 +1182,170 @@ TEST (block_store, state_block)
 	ASSERT_EQ (0, count2.state_v0);
 	ASSERT_EQ (0, count2.state_v1);
 }
+
+TEST (block_filter, insert_erase)
+{
+	rai::block_filter filter (64);
+	rai::block_hash hash1 (1);
+	rai::keypair key;
+	rai::block_hash hash2 (key.pub);
+	ASSERT_FALSE (filter.may_contain (hash1));
+	ASSERT_FALSE (filter.insert (hash1));
+	ASSERT_TRUE (filter.may_contain (hash1));
+	ASSERT_FALSE (filter.insert (hash2));
+	ASSERT_EQ (2, filter.size ());
+	filter.erase (hash1);
+	ASSERT_FALSE (filter.may_contain (hash1));
+	ASSERT_TRUE (filter.may_contain (hash2));
+	ASSERT_EQ (1, filter.size ());
+}
+
+TEST (block_filter, full)
+{
+	rai::block_filter filter (64);
+	std::vector<rai::block_hash> hashes;
+	auto full (false);
+	while (!full)
+	{
+		rai::keypair key;
+		full = filter.insert (key.pub);
+		if (!full)
+		{
+			hashes.push_back (key.pub);
+		}
+	}
+	ASSERT_LE (hashes.size (), filter.capacity () + 1);
+	// No false negatives, including the fingerprint that was left over
+	for (auto & hash : hashes)
+	{
+		ASSERT_TRUE (filter.may_contain (hash));
+	}
+	for (auto & hash : hashes)
+	{
+		filter.erase (hash);
+	}
+	ASSERT_EQ (0, filter.size ());
+	ASSERT_FALSE (filter.insert (hashes[0]));
+}
+
+TEST (block_filter, concurrent_reads)
+{
+	rai::block_filter filter (1024);
+	std::vector<rai::block_hash> hashes;
+	for (auto i (0); i < 256; ++i)
+	{
+		rai::keypair key;
+		ASSERT_FALSE (filter.insert (key.pub));
+		hashes.push_back (key.pub);
+	}
+	std::atomic<bool> done (false);
+	std::atomic<size_t> misses (0);
+	// Inserts below kick the stored fingerprints between buckets while they are read
+	std::thread reader ([&hashes, &filter, &done, &misses]() {
+		while (!done)
+		{
+			for (auto & hash : hashes)
+			{
+				if (!filter.may_contain (hash))
+				{
+					++misses;
+				}
+			}
+		}
+	});
+	auto full (false);
+	while (!full)
+	{
+		rai::keypair key;
+		full = filter.insert (key.pub);
+	}
+	done = true;
+	reader.join ();
+	ASSERT_EQ (0, misses);
+}
+
+TEST (block_store, filter_grow)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	// The startup filter has room for far more than this test stores, begin from a tiny one so it has to grow
+	store.filter = std::make_shared<rai::block_filter> (4);
+	rai::transaction transaction (store.environment, nullptr, true);
+	std::vector<rai::block_hash> hashes;
+	for (auto i (0); i < 100; ++i)
+	{
+		rai::open_block block (i, 1, i, rai::keypair ().prv, 0, 0);
+		store.block_put (transaction, block.hash (), block);
+		hashes.push_back (block.hash ());
+	}
+	ASSERT_EQ (100, store.filter->size ());
+	ASSERT_LE (100, store.filter->capacity ());
+	for (auto & hash : hashes)
+	{
+		ASSERT_TRUE (store.block_exists (transaction, hash));
+	}
+	store.block_del (transaction, hashes[0]);
+	ASSERT_FALSE (store.block_exists (transaction, hashes[0]));
+	ASSERT_EQ (99, store.filter->size ());
+}
+
+TEST (block_store, read_transaction_reuse)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	rai::open_block block (0, 1, 0, rai::keypair ().prv, 0, 0);
+	MDB_txn * handle1 (nullptr);
+	{
+		rai::transaction transaction (store.environment, nullptr, false);
+		handle1 = transaction;
+		ASSERT_FALSE (store.block_exists (transaction, block.hash ()));
+	}
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.block_put (transaction, block.hash (), block);
+	}
+	// The reset handle is renewed and sees the latest commit
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_EQ (handle1, static_cast<MDB_txn *> (transaction));
+	ASSERT_TRUE (store.block_exists (transaction, block.hash ()));
+	// A second concurrent reader gets its own handle
+	rai::transaction transaction2 (store.environment, nullptr, false);
+	ASSERT_NE (handle1, static_cast<MDB_txn *> (transaction2));
+}
+
+TEST (block_store, read_transaction_readers)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	unsigned readers (0);
+	ASSERT_EQ (0, mdb_env_get_maxreaders (store.environment, &readers));
+	ASSERT_LE (rai::mdb_env::readers_max, readers);
+	// More concurrent readers than the pool keeps, all returned handles stay usable afterwards
+	std::vector<std::unique_ptr<rai::transaction>> transactions;
+	for (auto i (0); i < 2 * rai::mdb_env::read_pool_max; ++i)
+	{
+		transactions.push_back (std::make_unique<rai::transaction> (store.environment, nullptr, false));
+	}
+	transactions.clear ();
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_FALSE (store.block_exists (transaction, 1));
+}
+
+TEST (block_store, not_durable)
+{
+	auto path (rai::unique_path ());
+	{
+		bool init (false);
+		rai::block_store store (init, path, 128, false);
+		ASSERT_FALSE (init);
+		rai::genesis genesis;
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.initialize (transaction, genesis);
+		ASSERT_TRUE (store.block_exists (transaction, genesis.hash ()));
+		ASSERT_TRUE (boost::filesystem::exists (path));
+	}
+	ASSERT_FALSE (boost::filesystem::exists (path));
+}
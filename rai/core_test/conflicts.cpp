@@ -9,14 +9,12 @@ TEST (conflicts, start_stop)
 	rai::keypair key1;
 	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
 	ASSERT_EQ (rai::process_result::progress, node1.process (*send1).code);
-	ASSERT_EQ (0, node1.active.roots.size ());
+	ASSERT_EQ (0, node1.active.size ());
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
-	ASSERT_EQ (1, node1.active.roots.size ());
+	ASSERT_EQ (1, node1.active.size ());
 	auto root1 (send1->root ());
-	auto existing1 (node1.active.roots.find (root1));
-	ASSERT_NE (node1.active.roots.end (), existing1);
-	auto votes1 (existing1->election);
+	auto votes1 (node1.active.election (root1));
 	ASSERT_NE (nullptr, votes1);
 	ASSERT_EQ (1, votes1->last_votes.size ());
 }
@@ -34,11 +32,11 @@ TEST (conflicts, add_existing)
 	rai::keypair key2;
 	auto send2 (std::make_shared<rai::send_block> (genesis.hash (), key2.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
 	node1.active.start (send2);
-	ASSERT_EQ (1, node1.active.roots.size ());
+	ASSERT_EQ (1, node1.active.size ());
 	auto vote1 (std::make_shared<rai::vote> (key2.pub, key2.prv, 0, send2));
 	node1.active.vote (vote1);
-	ASSERT_EQ (1, node1.active.roots.size ());
-	auto votes1 (node1.active.roots.find (send2->root ())->election);
+	ASSERT_EQ (1, node1.active.size ());
+	auto votes1 (node1.active.election (send2->root ()));
 	ASSERT_NE (nullptr, votes1);
 	ASSERT_EQ (2, votes1->last_votes.size ());
 	ASSERT_NE (votes1->last_votes.end (), votes1->last_votes.find (key2.pub));
@@ -58,5 +56,58 @@ TEST (conflicts, add_two)
 	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key2.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
 	ASSERT_EQ (rai::process_result::progress, node1.process (*send2).code);
 	node1.active.start (send2);
-	ASSERT_EQ (2, node1.active.roots.size ());
+	ASSERT_EQ (2, node1.active.size ());
+}
+
+TEST (conflicts, shards)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	std::vector<std::shared_ptr<rai::block>> blocks;
+	for (auto i (0); i < 64; ++i)
+	{
+		rai::keypair key1;
+		auto send1 (std::make_shared<rai::send_block> (key1.pub, key1.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+		ASSERT_FALSE (node1.active.start (send1));
+		blocks.push_back (send1);
+	}
+	ASSERT_EQ (64, node1.active.size ());
+	std::vector<rai::block_hash> hashes;
+	for (auto & block : blocks)
+	{
+		ASSERT_NE (nullptr, node1.active.election (block->root ()));
+		hashes.push_back (block->hash ());
+	}
+	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, hashes));
+	node1.active.vote (vote1);
+	for (auto & block : blocks)
+	{
+		auto election (node1.active.election (block->root ()));
+		ASSERT_NE (election->last_votes.end (), election->last_votes.find (rai::test_genesis_key.pub));
+	}
+}
+
+TEST (conflicts, priority)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	node1.work_generate_blocking (*send1);
+	auto send2 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, 1, rai::test_genesis_key.prv, rai::test_genesis_key.pub, send1->block_work ()));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send1).code);
+	auto now (std::chrono::steady_clock::now ());
+	rai::conflict_info local{ send1->root (), std::make_shared<rai::election> (node1, send1, [](std::shared_ptr<rai::block>) {}), 0, std::make_pair (send1, nullptr), now, now };
+	rai::conflict_info remote{ send2->root (), std::make_shared<rai::election> (node1, send2, [](std::shared_ptr<rai::block>) {}), 0, std::make_pair (send2, nullptr), now, now };
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	// Same root and work, only the local wallet origin differs
+	ASSERT_GT (node1.active.priority (transaction, local, now), node1.active.priority (transaction, remote, now));
+	// Waiting raises priority
+	ASSERT_GT (node1.active.priority (transaction, remote, now + std::chrono::milliseconds (rai::active_transactions::announce_interval_ms * 4)), node1.active.priority (transaction, local, now));
+	ASSERT_EQ (std::chrono::milliseconds (rai::active_transactions::announce_interval_min_ms), node1.active.announce_interval (0));
+	ASSERT_EQ (std::chrono::milliseconds (rai::active_transactions::announce_interval_ms), node1.active.announce_interval (rai::active_transactions::announcements_per_interval));
+	// A backlog larger than one round's budget is worked through at the shortest interval
+	ASSERT_EQ (std::chrono::milliseconds (rai::active_transactions::announce_interval_min_ms), node1.active.announce_interval (rai::active_transactions::announcements_per_interval + 1));
 }
@@ -784,7 +784,7 @@ TEST (votes, check_signature)
 	ASSERT_EQ (rai::process_result::progress, node1.ledger.process (transaction, *send1).code);
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
-	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto votes1 (node1.active.election (send1->root ()));
 	ASSERT_EQ (1, votes1->last_votes.size ());
 	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, send1));
 	vote1->signature.bytes[0] ^= 1;
@@ -794,6 +794,33 @@ TEST (votes, check_signature)
 	ASSERT_EQ (rai::vote_code::replay, node1.vote_processor.vote_blocking (transaction, vote1, rai::endpoint (boost::asio::ip::address_v6 (), 0)));
 }
 
+TEST (votes, verify_batch)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> votes;
+	for (auto i (0); i < 600; ++i)
+	{
+		auto vote (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, i, send1));
+		if (i % 100 == 0)
+		{
+			vote->signature.bytes[0] ^= 1;
+		}
+		votes.push_back (std::make_pair (vote, node1.network.endpoint ()));
+	}
+	node1.vote_processor.verify_votes (votes);
+	ASSERT_EQ (594, votes.size ());
+	for (auto & i : votes)
+	{
+		ASSERT_NE (0, i.first->sequence % 100);
+		ASSERT_FALSE (i.first->validate ());
+	}
+	ASSERT_EQ (6, node1.stats.count (rai::stat::type::vote, rai::stat::detail::vote_invalid));
+}
+
 TEST (votes, add_one)
 {
 	rai::system system (24000, 1);
@@ -807,7 +834,7 @@ TEST (votes, add_one)
 	}
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
-	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto votes1 (node1.active.election (send1->root ()));
 	ASSERT_EQ (1, votes1->last_votes.size ());
 	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, send1));
 	ASSERT_FALSE (node1.active.vote (vote1));
@@ -836,7 +863,7 @@ TEST (votes, add_two)
 	}
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
-	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto votes1 (node1.active.election (send1->root ()));
 	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, send1));
 	ASSERT_FALSE (node1.active.vote (vote1));
 	rai::keypair key2;
@@ -867,7 +894,7 @@ TEST (votes, add_existing)
 	}
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
-	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto votes1 (node1.active.election (send1->root ()));
 	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, send1));
 	ASSERT_FALSE (node1.active.vote (vote1));
 	ASSERT_FALSE (node1.active.publish (send1));
@@ -887,6 +914,8 @@ TEST (votes, add_existing)
 	ASSERT_EQ (2, votes1->last_votes.size ());
 	ASSERT_NE (votes1->last_votes.end (), votes1->last_votes.find (rai::test_genesis_key.pub));
 	ASSERT_EQ (send2->hash (), votes1->last_votes[rai::test_genesis_key.pub].hash);
+	ASSERT_EQ (0, votes1->last_tally[send1->hash ()]);
+	ASSERT_EQ (rai::genesis_amount - rai::Gxrb_ratio, votes1->last_tally[send2->hash ()]);
 	rai::transaction transaction (system.nodes[0]->store.environment, nullptr, false);
 	auto winner (*votes1->tally (transaction).begin ());
 	ASSERT_EQ (*send2, *winner.second);
@@ -904,7 +933,7 @@ TEST (votes, add_old)
 	ASSERT_EQ (rai::process_result::progress, node1.ledger.process (transaction, *send1).code);
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
-	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto votes1 (node1.active.election (send1->root ()));
 	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 2, send1));
 	node1.vote_processor.vote_blocking (transaction, vote1, node1.network.endpoint ());
 	rai::keypair key2;
@@ -936,8 +965,8 @@ TEST (votes, add_old_different_account)
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
 	node1.active.start (send2);
-	auto votes1 (node1.active.roots.find (send1->root ())->election);
-	auto votes2 (node1.active.roots.find (send2->root ())->election);
+	auto votes1 (node1.active.election (send1->root ()));
+	auto votes2 (node1.active.election (send2->root ()));
 	ASSERT_EQ (1, votes1->last_votes.size ());
 	ASSERT_EQ (1, votes2->last_votes.size ());
 	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 2, send1));
@@ -973,7 +1002,7 @@ TEST (votes, add_cooldown)
 	ASSERT_EQ (rai::process_result::progress, node1.ledger.process (transaction, *send1).code);
 	auto node_l (system.nodes[0]);
 	node1.active.start (send1);
-	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto votes1 (node1.active.election (send1->root ()));
 	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, send1));
 	node1.vote_processor.vote_blocking (transaction, vote1, node1.network.endpoint ());
 	rai::keypair key2;
@@ -1466,6 +1495,25 @@ TEST (ledger, latest_empty)
 	ASSERT_TRUE (latest.is_zero ());
 }
 
+// Blocks stored without sideband are resolved from the chain
+TEST (ledger, account_without_sideband)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::keypair key1;
+	rai::transaction transaction (store.environment, nullptr, true);
+	rai::send_block send (0, 1, 2, key1.prv, key1.pub, 0);
+	store.block_put (transaction, send.hash (), send);
+	store.frontier_put (transaction, send.hash (), key1.pub);
+	ASSERT_EQ (key1.pub, ledger.account (transaction, send.hash ()));
+	rai::state_block state (key1.pub, 0, 0, 0, 0, key1.prv, key1.pub, 0);
+	store.block_put (transaction, state.hash (), state);
+	ASSERT_EQ (key1.pub, ledger.account (transaction, state.hash ()));
+}
+
 TEST (ledger, latest_root)
 {
 	bool init (false);
@@ -2363,3 +2411,93 @@ TEST (ledger, epoch_blocks_fork)
 	rai::state_block epoch1 (rai::genesis_account, genesis.hash (), rai::genesis_account, rai::genesis_amount, 123, epoch_key.prv, epoch_key.pub, 0);
 	ASSERT_EQ (rai::process_result::fork, ledger.process (transaction, epoch1).code);
 }
+
+TEST (ledger, state_signature_verified)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::genesis genesis;
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.initialize (transaction, genesis);
+	rai::state_block send1 (rai::genesis_account, genesis.hash (), rai::genesis_account, rai::genesis_amount - rai::Gxrb_ratio, rai::genesis_account, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	send1.signature.bytes[32] ^= 0x1;
+	ASSERT_EQ (rai::process_result::bad_signature, ledger.process (transaction, send1).code);
+	// The ledger trusts a signature that was already checked upstream
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send1, rai::signature_verification::valid).code);
+}
+
+TEST (ledger, delegators_index)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::genesis genesis;
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.initialize (transaction, genesis);
+	auto delegators = [&store, &transaction](rai::account const & representative_a) {
+		std::vector<rai::account> result;
+		for (auto i (store.delegators_begin (transaction, representative_a)), n (store.delegators_end ()); i != n && rai::delegator_key (i->first).representative == representative_a; ++i)
+		{
+			result.push_back (rai::delegator_key (i->first).account);
+		}
+		return result;
+	};
+	ASSERT_EQ (std::vector<rai::account>{ rai::test_genesis_key.pub }, delegators (rai::test_genesis_key.pub));
+	rai::keypair key1;
+	rai::change_block change1 (genesis.hash (), key1.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, change1).code);
+	ASSERT_TRUE (delegators (rai::test_genesis_key.pub).empty ());
+	ASSERT_EQ (std::vector<rai::account>{ rai::test_genesis_key.pub }, delegators (key1.pub));
+	rai::keypair key2;
+	rai::send_block send1 (change1.hash (), key2.pub, 50, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send1).code);
+	rai::open_block open1 (send1.hash (), key1.pub, key2.pub, key2.prv, key2.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, open1).code);
+	ASSERT_EQ (2, delegators (key1.pub).size ());
+	ledger.rollback (transaction, open1.hash ());
+	ASSERT_EQ (std::vector<rai::account>{ rai::test_genesis_key.pub }, delegators (key1.pub));
+	ledger.rollback (transaction, change1.hash ());
+	ASSERT_TRUE (delegators (key1.pub).empty ());
+	ASSERT_EQ (std::vector<rai::account>{ rai::test_genesis_key.pub }, delegators (rai::test_genesis_key.pub));
+}
+
+TEST (ledger, heights_index)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::stat stats;
+	rai::ledger ledger (store, stats);
+	rai::genesis genesis;
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.initialize (transaction, genesis);
+	auto chain = [&store, &transaction](rai::account const & account_a) {
+		std::vector<rai::block_hash> result;
+		for (auto i (store.heights_begin (transaction, account_a, 1)), n (store.heights_end ()); i != n && rai::height_key (i->first).account == account_a; ++i)
+		{
+			EXPECT_EQ (result.size () + 1, rai::height_key (i->first).height);
+			result.push_back (rai::block_hash (i->second));
+		}
+		return result;
+	};
+	ASSERT_EQ (std::vector<rai::block_hash>{ genesis.hash () }, chain (rai::test_genesis_key.pub));
+	rai::keypair key1;
+	rai::send_block send1 (genesis.hash (), key1.pub, 50, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send1).code);
+	rai::send_block send2 (send1.hash (), key1.pub, 40, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send2).code);
+	rai::open_block open1 (send1.hash (), key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, open1).code);
+	ASSERT_EQ ((std::vector<rai::block_hash>{ genesis.hash (), send1.hash (), send2.hash () }), chain (rai::test_genesis_key.pub));
+	ASSERT_EQ (std::vector<rai::block_hash>{ open1.hash () }, chain (key1.pub));
+	ledger.rollback (transaction, send2.hash ());
+	ASSERT_EQ ((std::vector<rai::block_hash>{ genesis.hash (), send1.hash () }), chain (rai::test_genesis_key.pub));
+	ledger.rollback (transaction, send1.hash ());
+	ASSERT_EQ (std::vector<rai::block_hash>{ genesis.hash () }, chain (rai::test_genesis_key.pub));
+	ASSERT_TRUE (chain (key1.pub).empty ());
+}
@@ -75,7 +75,8 @@ TEST (message_parser, exact_confirm_ack_size)
 {
 	rai::system system (24000, 1);
 	test_visitor visitor;
-	rai::message_parser parser (visitor, system.work);
+	rai::block_uniquer block_uniquer;
+	rai::message_parser parser (block_uniquer, visitor, system.work);
 	auto block (std::unique_ptr<rai::send_block> (new rai::send_block (1, 1, 2, rai::keypair ().prv, 4, system.work.generate (1))));
 	auto vote (std::make_shared<rai::vote> (0, rai::keypair ().prv, 0, std::move (block)));
 	rai::confirm_ack message (vote);
@@ -106,7 +107,8 @@ TEST (message_parser, exact_confirm_req_size)
 {
 	rai::system system (24000, 1);
 	test_visitor visitor;
-	rai::message_parser parser (visitor, system.work);
+	rai::block_uniquer block_uniquer;
+	rai::message_parser parser (block_uniquer, visitor, system.work);
 	auto block (std::unique_ptr<rai::send_block> (new rai::send_block (1, 1, 2, rai::keypair ().prv, 4, system.work.generate (1))));
 	rai::confirm_req message (std::move (block));
 	std::vector<uint8_t> bytes;
@@ -136,7 +138,8 @@ TEST (message_parser, exact_publish_size)
 {
 	rai::system system (24000, 1);
 	test_visitor visitor;
-	rai::message_parser parser (visitor, system.work);
+	rai::block_uniquer block_uniquer;
+	rai::message_parser parser (block_uniquer, visitor, system.work);
 	auto block (std::unique_ptr<rai::send_block> (new rai::send_block (1, 1, 2, rai::keypair ().prv, 4, system.work.generate (1))));
 	rai::publish message (std::move (block));
 	std::vector<uint8_t> bytes;
@@ -166,7 +169,8 @@ TEST (message_parser, exact_keepalive_size)
 {
 	rai::system system (24000, 1);
 	test_visitor visitor;
-	rai::message_parser parser (visitor, system.work);
+	rai::block_uniquer block_uniquer;
+	rai::message_parser parser (block_uniquer, visitor, system.work);
 	rai::keepalive message;
 	std::vector<uint8_t> bytes;
 	{
@@ -190,3 +194,101 @@ TEST (message_parser, exact_keepalive_size)
 	ASSERT_EQ (1, visitor.keepalive_count);
 	ASSERT_NE (parser.status, rai::message_parser::parse_status::success);
 }
+
+TEST (message_parser, insufficient_work)
+{
+	rai::system system (24000, 1);
+	test_visitor visitor;
+	rai::block_uniquer block_uniquer;
+	rai::message_parser parser (block_uniquer, visitor, system.work);
+	auto block (std::make_shared<rai::send_block> (1, 1, 2, rai::keypair ().prv, 4, system.work.generate (1)));
+	rai::publish message (block);
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, rai::message_parser::parse_status::success);
+	ASSERT_EQ (1, visitor.publish_count);
+	block->block_work_set (block->block_work () + 1);
+	while (!rai::work_validate (*block))
+	{
+		block->block_work_set (block->block_work () + 1);
+	}
+	bytes.clear ();
+	{
+		rai::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, rai::message_parser::parse_status::insufficient_work);
+	ASSERT_EQ (1, visitor.publish_count);
+	auto vote (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 0, block));
+	rai::confirm_ack ack (vote);
+	bytes.clear ();
+	{
+		rai::vectorstream stream (bytes);
+		ack.serialize (stream);
+	}
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, rai::message_parser::parse_status::insufficient_work);
+	ASSERT_EQ (0, visitor.confirm_ack_count);
+	// A truncated block is rejected as malformed before any work is checked
+	bytes.pop_back ();
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, rai::message_parser::parse_status::invalid_confirm_ack_message);
+}
+
+TEST (message_filter, duplicate_publish)
+{
+	rai::system system (24000, 1);
+	rai::message_filter filter (1024);
+	auto block (std::make_shared<rai::send_block> (1, 1, 2, rai::keypair ().prv, 4, system.work.generate (1)));
+	rai::publish message (block);
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	ASSERT_FALSE (filter.apply (bytes.data (), bytes.size ()));
+	ASSERT_TRUE (filter.apply (bytes.data (), bytes.size ()));
+	// Peers relaying with a different protocol version still send the same payload
+	auto relayed (bytes);
+	relayed[3] = relayed[3] - 1;
+	ASSERT_TRUE (filter.apply (relayed.data (), relayed.size ()));
+	auto other (bytes);
+	other.back () ^= 1;
+	ASSERT_FALSE (filter.apply (other.data (), other.size ()));
+	// Keepalives carry peer lists which are expected to repeat, they're never filtered
+	rai::keepalive keepalive;
+	std::vector<uint8_t> keepalive_bytes;
+	{
+		rai::vectorstream stream (keepalive_bytes);
+		keepalive.serialize (stream);
+	}
+	ASSERT_FALSE (filter.apply (keepalive_bytes.data (), keepalive_bytes.size ()));
+	ASSERT_FALSE (filter.apply (keepalive_bytes.data (), keepalive_bytes.size ()));
+}
+
+TEST (message_filter, clear)
+{
+	rai::system system (24000, 1);
+	rai::message_filter filter (1024);
+	auto block (std::make_shared<rai::send_block> (1, 1, 2, rai::keypair ().prv, 4, system.work.generate (1)));
+	rai::publish message (block);
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	uint64_t digest (0);
+	ASSERT_FALSE (filter.apply (bytes.data (), bytes.size (), &digest));
+	ASSERT_EQ (filter.digest (block), digest);
+	filter.clear (digest);
+	ASSERT_FALSE (filter.apply (bytes.data (), bytes.size ()));
+	// Clearing from the block alone finds the same slot
+	filter.clear (filter.digest (block));
+	ASSERT_FALSE (filter.apply (bytes.data (), bytes.size ()));
+	ASSERT_TRUE (filter.apply (bytes.data (), bytes.size ()));
+}
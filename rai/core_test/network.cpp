@@ -55,9 +55,9 @@ TEST (network, construction)
 TEST (network, self_discard)
 {
 	rai::system system (24000, 1);
-	system.nodes[0]->network.remote = system.nodes[0]->network.endpoint ();
+	system.nodes[0]->network.receivers[0]->remote = system.nodes[0]->network.endpoint ();
 	ASSERT_EQ (0, system.nodes[0]->stats.count (rai::stat::type::error, rai::stat::detail::bad_sender));
-	system.nodes[0]->network.receive_action (boost::system::error_code{}, 0);
+	system.nodes[0]->network.receivers[0]->receive_action (boost::system::error_code{}, 0);
 	ASSERT_EQ (1, system.nodes[0]->stats.count (rai::stat::type::error, rai::stat::detail::bad_sender));
 }
 
@@ -145,6 +145,76 @@ TEST (network, multi_keepalive)
 	node2->stop ();
 }
 
+TEST (network, batch_io)
+{
+	rai::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	ASSERT_EQ (rai::udp_batch_supported (), node0->network.batch_io);
+	rai::node_init init1;
+	rai::node_config config1 (24001, system.logging);
+	config1.udp_batch_io = false;
+	auto node1 (std::make_shared<rai::node> (init1, system.service, rai::unique_path (), system.alarm, config1, system.work));
+	ASSERT_FALSE (init1.error ());
+	ASSERT_FALSE (node1->network.batch_io);
+	node1->start ();
+	auto initial0 (node0->stats.count (rai::stat::type::message, rai::stat::detail::keepalive, rai::stat::dir::in));
+	auto initial1 (node1->stats.count (rai::stat::type::message, rai::stat::detail::keepalive, rai::stat::dir::in));
+	for (auto i (0); i < 100; ++i)
+	{
+		node1->network.send_keepalive (node0->network.endpoint ());
+		node0->network.send_keepalive (node1->network.endpoint ());
+	}
+	system.deadline_set (10s);
+	while (node0->stats.count (rai::stat::type::message, rai::stat::detail::keepalive, rai::stat::dir::in) < initial0 + 100 || node1->stats.count (rai::stat::type::message, rai::stat::detail::keepalive, rai::stat::dir::in) < initial1 + 100)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	node1->stop ();
+}
+
+TEST (network, reuse_port)
+{
+	rai::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	rai::node_init init1;
+	rai::node_config config1 (0, system.logging);
+	config1.udp_sockets = 3;
+	auto node1 (std::make_shared<rai::node> (init1, system.service, rai::unique_path (), system.alarm, config1, system.work));
+	ASSERT_FALSE (init1.error ());
+	node1->start ();
+	auto port (node1->network.endpoint ().port ());
+	ASSERT_NE (0, port);
+	if (node1->network.receivers.size () > 1)
+	{
+		ASSERT_EQ (3, node1->network.receivers.size ());
+		for (auto & socket : node1->network.reuse_sockets)
+		{
+			ASSERT_EQ (port, socket.local_endpoint ().port ());
+		}
+	}
+	auto initial (node1->stats.count (rai::stat::type::message, rai::stat::detail::keepalive, rai::stat::dir::in));
+	for (auto i (0); i < 100; ++i)
+	{
+		node0->network.send_keepalive (node1->network.endpoint ());
+	}
+	system.deadline_set (10s);
+	while (node1->stats.count (rai::stat::type::message, rai::stat::detail::keepalive, rai::stat::dir::in) < initial + 100)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	node1->stop ();
+}
+
+// A port owned by another node must not be shared silently
+TEST (network, reuse_port_owned)
+{
+	rai::system system (24000, 1);
+	rai::node_init init1;
+	rai::node_config config1 (system.nodes[0]->network.endpoint ().port (), system.logging);
+	config1.udp_sockets = 3;
+	ASSERT_THROW (std::make_shared<rai::node> (init1, system.service, rai::unique_path (), system.alarm, config1, system.work), boost::system::system_error);
+}
+
 TEST (network, send_discarded_publish)
 {
 	rai::system system (24000, 2);
@@ -207,6 +277,27 @@ TEST (network, send_valid_confirm_ack)
 	ASSERT_EQ (50, system.nodes[1]->balance (rai::test_genesis_key.pub));
 }
 
+TEST (network, confirm_req_hashes)
+{
+	rai::system system (24000, 2);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	auto & node1 (*system.nodes[1]);
+	rai::genesis genesis;
+	// The second pair names an unknown block, it's answered with the block in its place
+	std::vector<std::pair<rai::block_hash, rai::block_hash>> roots_hashes{ { genesis.hash (), genesis.open->root () }, { 1, genesis.open->root () } };
+	node1.network.send_confirm_req_hashes (system.nodes[0]->network.endpoint (), roots_hashes);
+	std::shared_ptr<rai::vote> vote;
+	system.deadline_set (10s);
+	while (vote == nullptr)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+		rai::transaction transaction (node1.store.environment, nullptr, false);
+		std::lock_guard<std::mutex> lock (node1.store.cache_mutex);
+		vote = node1.store.vote_current (transaction, rai::test_genesis_key.pub);
+	}
+	ASSERT_EQ (std::vector<rai::block_hash>{ genesis.hash () }, std::vector<rai::block_hash> (vote->begin (), vote->end ()));
+}
+
 TEST (network, send_valid_publish)
 {
 	rai::system system (24000, 2);
@@ -432,6 +523,7 @@ TEST (bulk_pull, end_not_owned)
 	open.hashables.account = key2.pub;
 	open.hashables.representative = key2.pub;
 	open.hashables.source = latest;
+	open.refresh ();
 	open.signature = rai::sign_message (key2.prv, key2.pub, open.hash ());
 	ASSERT_EQ (rai::process_result::progress, system.nodes[0]->process (open).code);
 	auto connection (std::make_shared<rai::bootstrap_server> (nullptr, system.nodes[0]));
@@ -543,7 +635,7 @@ TEST (bootstrap_processor, process_one)
 	{
 		ASSERT_NO_ERROR (system.poll ());
 	}
-	ASSERT_EQ (0, node1->active.roots.size ());
+	ASSERT_EQ (0, node1->active.size ());
 	node1->stop ();
 }
 
@@ -596,7 +688,7 @@ TEST (bootstrap_processor, process_state)
 	{
 		ASSERT_NO_ERROR (system.poll ());
 	}
-	ASSERT_EQ (0, node1->active.roots.size ());
+	ASSERT_EQ (0, node1->active.size ());
 	node1->stop ();
 }
 
@@ -187,9 +187,9 @@ TEST (node, node_receive_quorum)
 	auto done (false);
 	while (!done)
 	{
-		auto info (system.nodes[0]->active.roots.find (previous));
-		ASSERT_NE (system.nodes[0]->active.roots.end (), info);
-		done = info->announcements > rai::active_transactions::announcement_min;
+		rai::conflict_info info;
+		ASSERT_FALSE (system.nodes[0]->active.conflict (previous, info));
+		done = info.announcements > rai::active_transactions::announcement_min;
 		ASSERT_NO_ERROR (system.poll ());
 	}
 	ASSERT_TRUE (system.nodes[0]->balance (key.pub).is_zero ());
@@ -481,6 +481,17 @@ TEST (node_config, serialization)
 	config1.callback_port = 10;
 	config1.callback_target = "test";
 	config1.lmdb_max_dbs = 256;
+	config1.signature_checker_threads = config1.signature_checker_threads + 3;
+	config1.udp_batch_io = !config1.udp_batch_io;
+	config1.udp_sockets = config1.udp_sockets + 2;
+	config1.block_processor_batch_max = config1.block_processor_batch_max / 2;
+	config1.block_processor_live_latency = config1.block_processor_live_latency * 2;
+	config1.block_processor_bootstrap_latency = config1.block_processor_bootstrap_latency * 2;
+	config1.unchecked_cache_max = config1.unchecked_cache_max / 2;
+	config1.unchecked_max = config1.unchecked_max / 2;
+	config1.unchecked_cutoff = config1.unchecked_cutoff * 2;
+	config1.store_backend = "volatile";
+	config1.vote_generator_delay = config1.vote_generator_delay + std::chrono::milliseconds (50);
 	boost::property_tree::ptree tree;
 	config1.serialize_json (tree);
 	rai::logging logging2;
@@ -498,6 +509,17 @@ TEST (node_config, serialization)
 	ASSERT_NE (config2.callback_port, config1.callback_port);
 	ASSERT_NE (config2.callback_target, config1.callback_target);
 	ASSERT_NE (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_NE (config2.signature_checker_threads, config1.signature_checker_threads);
+	ASSERT_NE (config2.udp_batch_io, config1.udp_batch_io);
+	ASSERT_NE (config2.udp_sockets, config1.udp_sockets);
+	ASSERT_NE (config2.block_processor_batch_max, config1.block_processor_batch_max);
+	ASSERT_NE (config2.block_processor_live_latency, config1.block_processor_live_latency);
+	ASSERT_NE (config2.block_processor_bootstrap_latency, config1.block_processor_bootstrap_latency);
+	ASSERT_NE (config2.unchecked_cache_max, config1.unchecked_cache_max);
+	ASSERT_NE (config2.unchecked_max, config1.unchecked_max);
+	ASSERT_NE (config2.unchecked_cutoff, config1.unchecked_cutoff);
+	ASSERT_NE (config2.store_backend, config1.store_backend);
+	ASSERT_NE (config2.vote_generator_delay, config1.vote_generator_delay);
 
 	ASSERT_FALSE (tree.get_optional<std::string> ("epoch_block_link"));
 	ASSERT_FALSE (tree.get_optional<std::string> ("epoch_block_signer"));
@@ -516,6 +538,17 @@ TEST (node_config, serialization)
 	ASSERT_EQ (config2.callback_port, config1.callback_port);
 	ASSERT_EQ (config2.callback_target, config1.callback_target);
 	ASSERT_EQ (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_EQ (config2.signature_checker_threads, config1.signature_checker_threads);
+	ASSERT_EQ (config2.udp_batch_io, config1.udp_batch_io);
+	ASSERT_EQ (config2.udp_sockets, config1.udp_sockets);
+	ASSERT_EQ (config2.block_processor_batch_max, config1.block_processor_batch_max);
+	ASSERT_EQ (config2.block_processor_live_latency, config1.block_processor_live_latency);
+	ASSERT_EQ (config2.block_processor_bootstrap_latency, config1.block_processor_bootstrap_latency);
+	ASSERT_EQ (config2.unchecked_cache_max, config1.unchecked_cache_max);
+	ASSERT_EQ (config2.unchecked_max, config1.unchecked_max);
+	ASSERT_EQ (config2.unchecked_cutoff, config1.unchecked_cutoff);
+	ASSERT_EQ (config2.store_backend, config1.store_backend);
+	ASSERT_EQ (config2.vote_generator_delay, config1.vote_generator_delay);
 }
 
 TEST (node_config, v1_v2_upgrade)
@@ -625,13 +658,17 @@ TEST (node, fork_publish)
 		node1.work_generate_blocking (*send2);
 		node1.process_active (send1);
 		node1.block_processor.flush ();
-		ASSERT_EQ (1, node1.active.roots.size ());
-		auto existing (node1.active.roots.find (send1->root ()));
-		ASSERT_NE (node1.active.roots.end (), existing);
-		auto election (existing->election);
+		ASSERT_EQ (1, node1.active.size ());
+		auto election (node1.active.election (send1->root ()));
+		ASSERT_NE (nullptr, election);
 		rai::transaction transaction (node1.store.environment, nullptr, false);
 		election->compute_rep_votes (transaction);
-		node1.vote_processor.flush ();
+		system.deadline_set (10s);
+		while (election->last_votes.size () < 2)
+		{
+			ASSERT_NO_ERROR (system.poll ());
+			node1.vote_processor.flush ();
+		}
 		ASSERT_EQ (2, election->last_votes.size ());
 		node1.process_active (send2);
 		node1.block_processor.flush ();
@@ -661,16 +698,14 @@ TEST (node, fork_keep)
 	node1.block_processor.flush ();
 	node2.process_active (send1);
 	node2.block_processor.flush ();
-	ASSERT_EQ (1, node1.active.roots.size ());
-	ASSERT_EQ (1, node2.active.roots.size ());
+	ASSERT_EQ (1, node1.active.size ());
+	ASSERT_EQ (1, node2.active.size ());
 	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
 	node1.process_active (send2);
 	node1.block_processor.flush ();
 	node2.process_active (send2);
 	node2.block_processor.flush ();
-	auto conflict (node2.active.roots.find (genesis.hash ()));
-	ASSERT_NE (node2.active.roots.end (), conflict);
-	auto votes1 (conflict->election);
+	auto votes1 (node2.active.election (genesis.hash ()));
 	ASSERT_NE (nullptr, votes1);
 	ASSERT_EQ (1, votes1->last_votes.size ());
 	{
@@ -712,16 +747,14 @@ TEST (node, fork_flip)
 	node1.block_processor.flush ();
 	node2.process_message (publish2, node1.network.endpoint ());
 	node2.block_processor.flush ();
-	ASSERT_EQ (1, node1.active.roots.size ());
-	ASSERT_EQ (1, node2.active.roots.size ());
+	ASSERT_EQ (1, node1.active.size ());
+	ASSERT_EQ (1, node2.active.size ());
 	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
 	node1.process_message (publish2, node1.network.endpoint ());
 	node1.block_processor.flush ();
 	node2.process_message (publish1, node2.network.endpoint ());
 	node2.block_processor.flush ();
-	auto conflict (node2.active.roots.find (genesis.hash ()));
-	ASSERT_NE (node2.active.roots.end (), conflict);
-	auto votes1 (conflict->election);
+	auto votes1 (node2.active.election (genesis.hash ()));
 	ASSERT_NE (nullptr, votes1);
 	ASSERT_EQ (1, votes1->last_votes.size ());
 	{
@@ -766,17 +799,15 @@ TEST (node, fork_multi_flip)
 	node2.process_message (publish2, node2.network.endpoint ());
 	node2.process_message (publish3, node2.network.endpoint ());
 	node2.block_processor.flush ();
-	ASSERT_EQ (1, node1.active.roots.size ());
-	ASSERT_EQ (2, node2.active.roots.size ());
+	ASSERT_EQ (1, node1.active.size ());
+	ASSERT_EQ (2, node2.active.size ());
 	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
 	node1.process_message (publish2, node1.network.endpoint ());
 	node1.process_message (publish3, node1.network.endpoint ());
 	node1.block_processor.flush ();
 	node2.process_message (publish1, node2.network.endpoint ());
 	node2.block_processor.flush ();
-	auto conflict (node2.active.roots.find (genesis.hash ()));
-	ASSERT_NE (node2.active.roots.end (), conflict);
-	auto votes1 (conflict->election);
+	auto votes1 (node2.active.election (genesis.hash ()));
 	ASSERT_NE (nullptr, votes1);
 	ASSERT_EQ (1, votes1->last_votes.size ());
 	{
@@ -861,7 +892,7 @@ TEST (node, fork_open)
 	node1.block_processor.flush ();
 	auto open2 (std::make_shared<rai::open_block> (publish1.block->hash (), 2, key1.pub, key1.prv, key1.pub, system.work.generate (key1.pub)));
 	rai::publish publish3 (open2);
-	ASSERT_EQ (2, node1.active.roots.size ());
+	ASSERT_EQ (2, node1.active.size ());
 	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
 	node1.process_message (publish3, node1.network.endpoint ());
 	node1.block_processor.flush ();
@@ -891,17 +922,15 @@ TEST (node, fork_open_flip)
 	// node2 gets copy that will be evicted
 	node2.process_active (open2);
 	node2.block_processor.flush ();
-	ASSERT_EQ (2, node1.active.roots.size ());
-	ASSERT_EQ (2, node2.active.roots.size ());
+	ASSERT_EQ (2, node1.active.size ());
+	ASSERT_EQ (2, node2.active.size ());
 	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
 	// Notify both nodes that a fork exists
 	node1.process_active (open2);
 	node1.block_processor.flush ();
 	node2.process_active (open1);
 	node2.block_processor.flush ();
-	auto conflict (node2.active.roots.find (open1->root ()));
-	ASSERT_NE (node2.active.roots.end (), conflict);
-	auto votes1 (conflict->election);
+	auto votes1 (node2.active.election (open1->root ()));
 	ASSERT_NE (nullptr, votes1);
 	ASSERT_EQ (1, votes1->last_votes.size ());
 	ASSERT_TRUE (node1.block (open1->hash ()) != nullptr);
@@ -1171,12 +1200,17 @@ TEST (node, rep_self_vote)
 	ASSERT_EQ (rai::process_result::progress, node0->process (*block0).code);
 	auto & active (node0->active);
 	active.start (block0);
-	auto existing (active.roots.find (block0->root ()));
-	ASSERT_NE (active.roots.end (), existing);
+	auto election (active.election (block0->root ()));
+	ASSERT_NE (nullptr, election);
 	rai::transaction transaction (node0->store.environment, nullptr, false);
-	existing->election->compute_rep_votes (transaction);
-	node0->vote_processor.flush ();
-	auto & rep_votes (existing->election->last_votes);
+	election->compute_rep_votes (transaction);
+	system.deadline_set (10s);
+	while (election->last_votes.size () < 3)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+		node0->vote_processor.flush ();
+	}
+	auto & rep_votes (election->last_votes);
 	ASSERT_EQ (3, rep_votes.size ());
 	ASSERT_NE (rep_votes.end (), rep_votes.find (rai::test_genesis_key.pub));
 	ASSERT_NE (rep_votes.end (), rep_votes.find (rep_big.pub));
@@ -1198,7 +1232,7 @@ TEST (node, DISABLED_bootstrap_no_publish)
 	}
 	ASSERT_FALSE (node1->bootstrap_initiator.in_progress ());
 	node1->bootstrap_initiator.bootstrap (node0->network.endpoint ());
-	ASSERT_TRUE (node1->active.roots.empty ());
+	ASSERT_TRUE (node1->active.empty ());
 	system1.deadline_set (10s);
 	while (node1->block (send0.hash ()) == nullptr)
 	{
@@ -1206,7 +1240,7 @@ TEST (node, DISABLED_bootstrap_no_publish)
 		system0.poll ();
 		auto ec = system1.poll ();
 		// There should never be an active transaction because the only activity is bootstrapping 1 block which shouldn't be publishing.
-		ASSERT_TRUE (node1->active.roots.empty ());
+		ASSERT_TRUE (node1->active.empty ());
 		ASSERT_NO_ERROR (ec);
 	}
 }
@@ -1228,7 +1262,7 @@ TEST (node, bootstrap_bulk_push)
 	}
 	ASSERT_FALSE (node0->bootstrap_initiator.in_progress ());
 	ASSERT_FALSE (node1->bootstrap_initiator.in_progress ());
-	ASSERT_TRUE (node1->active.roots.empty ());
+	ASSERT_TRUE (node1->active.empty ());
 	node0->bootstrap_initiator.bootstrap (node1->network.endpoint (), false);
 	system1.deadline_set (10s);
 	while (node1->block (send0.hash ()) == nullptr)
@@ -1237,7 +1271,7 @@ TEST (node, bootstrap_bulk_push)
 		ASSERT_NO_ERROR (system1.poll ());
 	}
 	// since this uses bulk_push, the new block should be republished
-	ASSERT_FALSE (node1->active.roots.empty ());
+	ASSERT_FALSE (node1->active.empty ());
 }
 
 // Bootstrapping a forked open block should succeed.
@@ -1266,7 +1300,7 @@ TEST (node, bootstrap_fork_open)
 	}
 	ASSERT_FALSE (node1->bootstrap_initiator.in_progress ());
 	node1->bootstrap_initiator.bootstrap (node0->network.endpoint ());
-	ASSERT_TRUE (node1->active.roots.empty ());
+	ASSERT_TRUE (node1->active.empty ());
 	system0.deadline_set (10s);
 	while (node1->ledger.block_exists (open1.hash ()))
 	{
@@ -1355,7 +1389,7 @@ TEST (node, no_voting)
 	// Broadcast a confirm so others should know this is a rep node
 	wallet0->send_action (rai::test_genesis_key.pub, key1.pub, rai::Mxrb_ratio);
 	system.deadline_set (10s);
-	while (!node1.active.roots.empty ())
+	while (!node1.active.empty ())
 	{
 		ASSERT_NO_ERROR (system.poll ());
 	}
@@ -1548,6 +1582,19 @@ TEST (node, block_arrival)
 	ASSERT_EQ (2, node.block_arrival.arrival.size ());
 }
 
+TEST (node, block_arrival_remove)
+{
+	rai::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	rai::block_hash hash1 (1);
+	ASSERT_FALSE (node.block_arrival.add (hash1));
+	ASSERT_TRUE (node.block_arrival.add (hash1));
+	node.block_arrival.remove (hash1);
+	ASSERT_FALSE (node.block_arrival.recent (hash1));
+	// A block dropped from the queue can arrive again
+	ASSERT_FALSE (node.block_arrival.add (hash1));
+}
+
 TEST (node, block_arrival_size)
 {
 	rai::system system (24000, 1);
@@ -1593,18 +1640,295 @@ TEST (node, confirm_quorum)
 	}
 	system.wallet (0)->send_action (rai::test_genesis_key.pub, rai::test_genesis_key.pub, rai::Gxrb_ratio);
 	system.deadline_set (10s);
-	while (system.nodes[0]->active.roots.empty ())
+	while (system.nodes[0]->active.empty ())
 	{
 		ASSERT_NO_ERROR (system.poll ());
 	}
 	auto done (false);
 	while (!done)
 	{
-		ASSERT_FALSE (system.nodes[0]->active.roots.empty ());
-		auto info (system.nodes[0]->active.roots.find (send1->hash ()));
-		ASSERT_NE (system.nodes[0]->active.roots.end (), info);
-		done = info->announcements > rai::active_transactions::announcement_min;
+		ASSERT_FALSE (system.nodes[0]->active.empty ());
+		rai::conflict_info info;
+		ASSERT_FALSE (system.nodes[0]->active.conflict (send1->hash (), info));
+		done = info.announcements > rai::active_transactions::announcement_min;
 		ASSERT_NO_ERROR (system.poll ());
 	}
 	ASSERT_EQ (0, system.nodes[0]->balance (rai::test_genesis_key.pub));
 }
+
+TEST (signature_checker, many)
+{
+	rai::signature_checker checker (2);
+	rai::signature_check_set check;
+	for (auto i (0); i < 1000; ++i)
+	{
+		rai::keypair key;
+		rai::uint256_union message (i);
+		check.add (message, key.pub, rai::sign_message (key.prv, key.pub, message));
+	}
+	check.signatures[10].bytes[32] ^= 0x1;
+	check.signatures[900].bytes[32] ^= 0x1;
+	checker.verify (check);
+	for (auto i (0); i < 1000; ++i)
+	{
+		ASSERT_EQ ((i == 10 || i == 900) ? 0 : 1, check.verifications[i]);
+	}
+}
+
+// Batch verification draws randomness on every calling thread, concurrent callers must not share a generator
+TEST (signature_checker, concurrent_callers)
+{
+	rai::signature_checker checker (2);
+	std::vector<std::thread> threads;
+	std::atomic<unsigned> failures (0);
+	for (auto t (0); t < 4; ++t)
+	{
+		threads.push_back (std::thread ([&checker, &failures]() {
+			rai::signature_check_set check;
+			for (auto i (0); i < 600; ++i)
+			{
+				rai::keypair key;
+				rai::uint256_union message (i);
+				check.add (message, key.pub, rai::sign_message (key.prv, key.pub, message));
+			}
+			check.signatures[300].bytes[32] ^= 0x1;
+			checker.verify (check);
+			for (auto i (0); i < 600; ++i)
+			{
+				if (check.verifications[i] != (i == 300 ? 0 : 1))
+				{
+					++failures;
+				}
+			}
+		}));
+	}
+	for (auto & thread : threads)
+	{
+		thread.join ();
+	}
+	ASSERT_EQ (0, failures);
+}
+
+TEST (node, block_processor_signatures)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key;
+	auto send1 (std::make_shared<rai::state_block> (rai::test_genesis_key.pub, genesis.hash (), rai::test_genesis_key.pub, rai::genesis_amount - rai::Gxrb_ratio, key.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, node1.work_generate_blocking (genesis.hash ())));
+	auto send2 (std::make_shared<rai::state_block> (rai::test_genesis_key.pub, send1->hash (), rai::test_genesis_key.pub, rai::genesis_amount - 2 * rai::Gxrb_ratio, key.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, node1.work_generate_blocking (send1->hash ())));
+	send2->signature.bytes[32] ^= 0x1;
+	auto open1 (std::make_shared<rai::open_block> (send1->hash (), key.pub, key.pub, key.prv, key.pub, node1.work_generate_blocking (key.pub)));
+	node1.block_processor.add (send1, std::chrono::steady_clock::now ());
+	node1.block_processor.add (send2, std::chrono::steady_clock::now ());
+	node1.block_processor.add (open1, std::chrono::steady_clock::now ());
+	node1.block_processor.flush ();
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	ASSERT_TRUE (node1.store.block_exists (transaction, send1->hash ()));
+	ASSERT_FALSE (node1.store.block_exists (transaction, send2->hash ()));
+	ASSERT_TRUE (node1.store.block_exists (transaction, open1->hash ()));
+}
+
+TEST (block_queue, local_first)
+{
+	rai::block_queue queue;
+	auto block1 (std::make_shared<rai::send_block> (0, 1, 2, rai::keypair ().prv, 4, 5));
+	auto block2 (std::make_shared<rai::send_block> (1, 1, 2, rai::keypair ().prv, 4, 5));
+	auto block3 (std::make_shared<rai::send_block> (2, 1, 2, rai::keypair ().prv, 4, 5));
+	auto now (std::chrono::steady_clock::now ());
+	ASSERT_EQ (nullptr, queue.push ({ block1, now, rai::signature_verification::unknown, rai::block_origin::bootstrap }, 1));
+	ASSERT_EQ (nullptr, queue.push ({ block2, now, rai::signature_verification::unknown, rai::block_origin::live }, 2));
+	ASSERT_EQ (nullptr, queue.push ({ block3, now, rai::signature_verification::unknown, rai::block_origin::local }, 0));
+	ASSERT_EQ (3, queue.size ());
+	ASSERT_EQ (1, queue.size (rai::block_origin::bootstrap));
+	ASSERT_EQ (block3, queue.pop ().block);
+	ASSERT_EQ (block2, queue.pop ().block);
+	ASSERT_EQ (block1, queue.pop ().block);
+	ASSERT_TRUE (queue.empty ());
+}
+
+TEST (block_queue_lane, round_robin)
+{
+	rai::block_queue_lane lane (16);
+	std::vector<std::shared_ptr<rai::block>> blocks;
+	for (auto i (0); i < 4; ++i)
+	{
+		blocks.push_back (std::make_shared<rai::send_block> (i, 1, 2, rai::keypair ().prv, 4, 5));
+	}
+	auto now (std::chrono::steady_clock::now ());
+	ASSERT_EQ (nullptr, lane.push ({ blocks[0], now, rai::signature_verification::unknown, rai::block_origin::live }, 1, 3));
+	ASSERT_EQ (nullptr, lane.push ({ blocks[1], now, rai::signature_verification::unknown, rai::block_origin::live }, 1, 1));
+	ASSERT_EQ (nullptr, lane.push ({ blocks[2], now, rai::signature_verification::unknown, rai::block_origin::live }, 1, 2));
+	ASSERT_EQ (nullptr, lane.push ({ blocks[3], now, rai::signature_verification::unknown, rai::block_origin::live }, 2, 1));
+	ASSERT_EQ (blocks[0], lane.pop ().block);
+	ASSERT_EQ (blocks[3], lane.pop ().block);
+	ASSERT_EQ (blocks[2], lane.pop ().block);
+	ASSERT_EQ (blocks[1], lane.pop ().block);
+	ASSERT_TRUE (lane.empty ());
+}
+
+TEST (block_queue_lane, overflow)
+{
+	rai::block_queue_lane lane (2);
+	std::vector<std::shared_ptr<rai::block>> blocks;
+	for (auto i (0); i < 8; ++i)
+	{
+		blocks.push_back (std::make_shared<rai::send_block> (i, 1, 2, rai::keypair ().prv, 4, 5));
+	}
+	auto now (std::chrono::steady_clock::now ());
+	ASSERT_EQ (nullptr, lane.push ({ blocks[0], now, rai::signature_verification::unknown, rai::block_origin::live }, 1, 2));
+	ASSERT_EQ (nullptr, lane.push ({ blocks[1], now, rai::signature_verification::unknown, rai::block_origin::live }, 1, 1));
+	// The noisy source loses its own least difficult block
+	ASSERT_EQ (blocks[2], lane.push ({ blocks[2], now, rai::signature_verification::unknown, rai::block_origin::live }, 1, 1));
+	// Another source displaces the least difficult block of the noisy one
+	ASSERT_EQ (blocks[1], lane.push ({ blocks[3], now, rai::signature_verification::unknown, rai::block_origin::live }, 2, 1));
+	ASSERT_EQ (2, lane.size ());
+	// Blocks released from unchecked displace other sources and are kept even past the limit
+	ASSERT_NE (nullptr, lane.push ({ blocks[4], now, rai::signature_verification::unknown, rai::block_origin::live }, 0, 0));
+	ASSERT_NE (nullptr, lane.push ({ blocks[5], now, rai::signature_verification::unknown, rai::block_origin::live }, 0, 0));
+	ASSERT_EQ (2, lane.size ());
+	ASSERT_EQ (nullptr, lane.push ({ blocks[6], now, rai::signature_verification::unknown, rai::block_origin::live }, 0, 0));
+	ASSERT_EQ (3, lane.size ());
+	ASSERT_EQ (blocks[7], lane.push ({ blocks[7], now, rai::signature_verification::unknown, rai::block_origin::live }, 1, 1));
+	ASSERT_EQ (3, lane.size ());
+}
+
+TEST (write_batch_controller, adapt)
+{
+	rai::write_batch_controller batch (64, 16384);
+	// Nothing measured yet, the time cutoff bounds the first transaction
+	ASSERT_EQ (16384, batch.batch_size (std::chrono::milliseconds (100)));
+	batch.record (1000, std::chrono::milliseconds (100), std::chrono::milliseconds (20));
+	ASSERT_EQ (std::chrono::microseconds (100), batch.per_block);
+	ASSERT_EQ (800, batch.batch_size (std::chrono::milliseconds (100)));
+	ASSERT_EQ (9800, batch.batch_size (std::chrono::milliseconds (1000)));
+	ASSERT_EQ (64, batch.batch_size (std::chrono::milliseconds (10)));
+	// Slower commits shrink the batch
+	batch.record (1000, std::chrono::milliseconds (100), std::chrono::milliseconds (60));
+	ASSERT_EQ (std::chrono::milliseconds (30), batch.commit);
+	ASSERT_EQ (700, batch.batch_size (std::chrono::milliseconds (100)));
+	// Empty transactions carry no timing information
+	batch.record (0, std::chrono::milliseconds (0), std::chrono::milliseconds (500));
+	ASSERT_EQ (std::chrono::milliseconds (30), batch.commit);
+}
+
+TEST (block_processor, legacy_signature)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key;
+	rai::genesis genesis;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	// Signed by the wrong key, the signer is only known from the account of its previous block
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key.pub, rai::genesis_amount - 200, key.prv, key.pub, system.work.generate (send1->hash ())));
+	auto send3 (std::make_shared<rai::send_block> (send1->hash (), key.pub, rai::genesis_amount - 300, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (send1->hash ())));
+	node1.block_processor.add (send1, std::chrono::steady_clock::now ());
+	node1.block_processor.flush ();
+	node1.block_processor.add (send2, std::chrono::steady_clock::now ());
+	node1.block_processor.flush ();
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, false);
+		ASSERT_TRUE (node1.store.block_exists (transaction, send1->hash ()));
+		ASSERT_FALSE (node1.store.block_exists (transaction, send2->hash ()));
+	}
+	node1.block_processor.add (send3, std::chrono::steady_clock::now ());
+	node1.block_processor.flush ();
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	ASSERT_TRUE (node1.store.block_exists (transaction, send3->hash ()));
+}
+
+// Blocks following an unstored block in the same batch take its account
+TEST (block_processor, legacy_signature_chain)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key;
+	rai::genesis genesis;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key.pub, rai::genesis_amount - 200, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (send1->hash ())));
+	// Signed by the wrong key
+	auto send3 (std::make_shared<rai::send_block> (send2->hash (), key.pub, rai::genesis_amount - 300, key.prv, key.pub, system.work.generate (send2->hash ())));
+	node1.block_processor.add (send1, std::chrono::steady_clock::now ());
+	node1.block_processor.add (send2, std::chrono::steady_clock::now ());
+	node1.block_processor.add (send3, std::chrono::steady_clock::now ());
+	node1.block_processor.flush ();
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	ASSERT_TRUE (node1.store.block_exists (transaction, send1->hash ()));
+	ASSERT_TRUE (node1.store.block_exists (transaction, send2->hash ()));
+	ASSERT_FALSE (node1.store.block_exists (transaction, send3->hash ()));
+}
+
+TEST (node, unchecked_cleanup)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key;
+	auto send1 (std::make_shared<rai::send_block> (1, key.pub, 0, key.prv, key.pub, 0));
+	auto send2 (std::make_shared<rai::send_block> (2, key.pub, 0, key.prv, key.pub, 0));
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		node1.store.unchecked_put (transaction, send1->previous (), send1);
+		node1.store.unchecked_put (transaction, send2->previous (), send2);
+		node1.store.flush (transaction);
+		// Age the first entry past the cutoff
+		rai::unchecked_key key1 (send1->previous (), send1->hash ());
+		rai::unchecked_info info1 (send1, rai::seconds_since_epoch () - node1.config.unchecked_cutoff.count () - 1);
+		ASSERT_EQ (0, mdb_put (transaction, node1.store.unchecked, rai::mdb_val (key1), rai::mdb_val (info1), 0));
+	}
+	ASSERT_EQ (1, node1.unchecked_cleanup ());
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	ASSERT_EQ (1, node1.store.unchecked_count (transaction));
+	ASSERT_TRUE (node1.store.unchecked_get (transaction, send1->previous ()).empty ());
+	ASSERT_EQ (1, node1.store.unchecked_get (transaction, send2->previous ()).size ());
+}
+
+// Scans and deletes resume across several batches
+TEST (node, unchecked_cleanup_batches)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key;
+	auto count (2 * rai::node::unchecked_cleanup_batch + 1);
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		for (size_t i (0); i < count; ++i)
+		{
+			auto send (std::make_shared<rai::send_block> (i, key.pub, 0, key.prv, key.pub, 0));
+			rai::unchecked_key key1 (send->previous (), send->hash ());
+			rai::unchecked_info info1 (send, rai::seconds_since_epoch () - node1.config.unchecked_cutoff.count () - 1 - i);
+			ASSERT_EQ (0, mdb_put (transaction, node1.store.unchecked, rai::mdb_val (key1), rai::mdb_val (info1), 0));
+		}
+	}
+	ASSERT_EQ (count, node1.unchecked_cleanup ());
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	ASSERT_EQ (0, node1.store.unchecked_count (transaction));
+}
+
+TEST (vote_generator, bundle)
+{
+	rai::system system (24000, 1);
+	rai::node_init init1;
+	rai::node_config config1 (24001, system.logging);
+	// Holds the first hash back long enough for the second to join it
+	config1.vote_generator_delay = std::chrono::seconds (1);
+	auto node (std::make_shared<rai::node> (init1, system.service, rai::unique_path (), system.alarm, config1, system.work));
+	auto & node1 (*node);
+	auto wallet (node1.wallets.create (rai::uint256_union ()));
+	ASSERT_NE (nullptr, wallet);
+	wallet->insert_adhoc (rai::test_genesis_key.prv);
+	node1.vote_generator.add (1);
+	node1.vote_generator.add (2);
+	std::shared_ptr<rai::vote> vote;
+	system.deadline_set (10s);
+	while (vote == nullptr)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+		rai::transaction transaction (node1.store.environment, nullptr, false);
+		std::lock_guard<std::mutex> lock (node1.store.cache_mutex);
+		vote = node1.store.vote_current (transaction, rai::test_genesis_key.pub);
+	}
+	// Both hashes are covered by a single signed vote
+	ASSERT_EQ (1, vote->sequence);
+	ASSERT_EQ ((std::vector<rai::block_hash>{ 1, 2 }), std::vector<rai::block_hash> (vote->begin (), vote->end ()));
+	node1.stop ();
+}
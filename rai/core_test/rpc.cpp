@@ -993,6 +993,49 @@ TEST (rpc, history_count)
 	ASSERT_EQ (1, history_node.size ());
 }
 
+TEST (rpc, account_history_offset)
+{
+	rai::system system (24000, 1);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	auto change (system.wallet (0)->change_action (rai::test_genesis_key.pub, rai::test_genesis_key.pub));
+	ASSERT_NE (nullptr, change);
+	auto send (system.wallet (0)->send_action (rai::test_genesis_key.pub, rai::test_genesis_key.pub, system.nodes[0]->config.receive_minimum.number ()));
+	ASSERT_NE (nullptr, send);
+	auto receive (system.wallet (0)->receive_action (static_cast<rai::send_block &> (*send), rai::test_genesis_key.pub, system.nodes[0]->config.receive_minimum.number ()));
+	ASSERT_NE (nullptr, receive);
+	rai::rpc rpc (system.service, *system.nodes[0], rai::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "account_history");
+	request.put ("account", rai::test_genesis_key.pub.to_account ());
+	request.put ("raw", true);
+	request.put ("count", 2);
+	request.put ("offset", 1);
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response.status);
+	std::vector<std::string> hashes;
+	for (auto & entry : response.json.get_child ("history"))
+	{
+		hashes.push_back (entry.second.get<std::string> ("hash"));
+	}
+	ASSERT_EQ ((std::vector<std::string>{ send->hash ().to_string (), change->hash ().to_string () }), hashes);
+	rai::genesis genesis;
+	ASSERT_EQ (genesis.hash ().to_string (), response.json.get<std::string> ("previous"));
+	request.put ("offset", 4);
+	test_response response2 (request, rpc, system.service);
+	while (response2.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response2.status);
+	ASSERT_TRUE (response2.json.get_child ("history").empty ());
+	ASSERT_FALSE (response2.json.get_optional<std::string> ("previous").is_initialized ());
+}
+
 TEST (rpc, process_block)
 {
 	rai::system system (24000, 1);
@@ -2849,6 +2892,44 @@ TEST (rpc, delegators)
 	ASSERT_EQ ("340282366920938463463374607431768211355", delegators.get<std::string> (key.pub.to_account ()));
 }
 
+TEST (rpc, delegators_paging)
+{
+	rai::system system (24000, 1);
+	rai::keypair key;
+	auto & node1 (*system.nodes[0]);
+	auto latest (node1.latest (rai::test_genesis_key.pub));
+	rai::send_block send (latest, key.pub, 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, node1.work_generate_blocking (latest));
+	ASSERT_EQ (rai::process_result::progress, node1.process (send).code);
+	rai::open_block open (send.hash (), rai::test_genesis_key.pub, key.pub, key.prv, key.pub, node1.work_generate_blocking (key.pub));
+	ASSERT_EQ (rai::process_result::progress, node1.process (open).code);
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "delegators");
+	request.put ("account", rai::test_genesis_key.pub.to_account ());
+	request.put ("count", "1");
+	test_response response1 (request, rpc, system.service);
+	while (response1.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response1.status);
+	ASSERT_EQ (1, response1.json.get_child ("delegators").size ());
+	// Delegators are listed in account order starting from "start"
+	auto last (std::max (rai::test_genesis_key.pub, key.pub, [](rai::account const & a, rai::account const & b) { return a < b; }));
+	request.erase ("count");
+	request.put ("start", last.to_account ());
+	test_response response2 (request, rpc, system.service);
+	while (response2.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response2.status);
+	auto & delegators_node (response2.json.get_child ("delegators"));
+	ASSERT_EQ (1, delegators_node.size ());
+	ASSERT_EQ (last.to_account (), delegators_node.begin ()->first);
+}
+
 TEST (rpc, delegators_count)
 {
 	rai::system system (24000, 1);
@@ -72,6 +72,21 @@ TEST (wallets, remove)
 	}
 }
 
+// Keys in a volatile store would be deleted on shutdown
+TEST (wallets, volatile_store)
+{
+	rai::system system (24000, 1);
+	rai::node_init init;
+	rai::node_config config (24001, system.logging);
+	config.store_backend = "volatile";
+	auto node (std::make_shared<rai::node> (init, system.service, rai::unique_path (), system.alarm, config, system.work));
+	ASSERT_FALSE (init.error ());
+	ASSERT_FALSE (node->store.environment.durable);
+	ASSERT_EQ (nullptr, node->wallets.create (rai::uint256_union (1)));
+	ASSERT_TRUE (node->wallets.items.empty ());
+	node->stop ();
+}
+
 // Keeps breaking whenever we add new DBs
 TEST (wallets, DISABLED_wallet_create_max)
 {
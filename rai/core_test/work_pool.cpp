@@ -20,6 +20,37 @@ TEST (work, validate)
 	ASSERT_FALSE (rai::work_validate (send_block));
 }
 
+TEST (work, validate_serialized)
+{
+	rai::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	rai::keypair key;
+	std::vector<std::unique_ptr<rai::block>> blocks;
+	blocks.push_back (std::make_unique<rai::send_block> (1, 2, 3, key.prv, key.pub, 0));
+	blocks.push_back (std::make_unique<rai::receive_block> (1, 2, key.prv, key.pub, 0));
+	blocks.push_back (std::make_unique<rai::open_block> (1, 2, 3, key.prv, key.pub, 0));
+	blocks.push_back (std::make_unique<rai::change_block> (1, 2, key.prv, key.pub, 0));
+	blocks.push_back (std::make_unique<rai::state_block> (1, 2, 3, 4, 5, key.prv, key.pub, 0));
+	blocks.push_back (std::make_unique<rai::state_block> (1, 0, 3, 4, 5, key.prv, key.pub, 0));
+	for (auto & block : blocks)
+	{
+		std::vector<uint8_t> bytes;
+		block->block_work_set (pool.generate (block->root ()));
+		{
+			rai::vectorstream stream (bytes);
+			block->serialize (stream);
+		}
+		ASSERT_FALSE (rai::work_validate (block->type (), bytes.data (), bytes.size ()));
+		ASSERT_TRUE (rai::work_validate (block->type (), bytes.data (), bytes.size () - 1));
+		// Changing the work should agree with validating the deserialized block
+		bytes[bytes.size () - 1] ^= 1;
+		bytes[bytes.size () - 8] ^= 1;
+		rai::bufferstream stream (bytes.data (), bytes.size ());
+		auto block_l (rai::deserialize_block (stream, block->type ()));
+		ASSERT_NE (nullptr, block_l);
+		ASSERT_EQ (rai::work_validate (*block_l), rai::work_validate (block->type (), bytes.data (), bytes.size ()));
+	}
+}
+
 TEST (work, cancel)
 {
 	rai::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
@@ -57,18 +57,85 @@ std::string rai::block::to_json ()
 	return result;
 }
 
-rai::block_hash rai::block::hash () const
+rai::block::block () :
+cached_state (hash_state::empty)
 {
-	rai::uint256_union result;
-	blake2b_state hash_l;
-	auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
+}
+
+rai::block::block (rai::block const & other_a) :
+cached_state (hash_state::empty)
+{
+	if (other_a.cached_state.load (std::memory_order_acquire) == hash_state::cached)
+	{
+		cached_hash = other_a.cached_hash;
+		cached_state.store (hash_state::cached, std::memory_order_release);
+	}
+}
+
+rai::block & rai::block::operator= (rai::block const & other_a)
+{
+	if (this != &other_a)
+	{
+		refresh ();
+		if (other_a.cached_state.load (std::memory_order_acquire) == hash_state::cached)
+		{
+			cached_hash = other_a.cached_hash;
+			cached_state.store (hash_state::cached, std::memory_order_release);
+		}
+	}
+	return *this;
+}
+
+rai::block_hash rai::block::full_hash () const
+{
+	rai::block_hash result;
+	blake2b_state state;
+	auto status (blake2b_init (&state, sizeof (result.bytes)));
+	assert (status == 0);
+	auto hash_l (hash ());
+	status = blake2b_update (&state, hash_l.bytes.data (), sizeof (hash_l.bytes));
 	assert (status == 0);
-	hash (hash_l);
-	status = blake2b_final (&hash_l, result.bytes.data (), sizeof (result.bytes));
+	auto signature (block_signature ());
+	status = blake2b_update (&state, signature.bytes.data (), sizeof (signature.bytes));
+	assert (status == 0);
+	auto work (block_work ());
+	status = blake2b_update (&state, &work, sizeof (work));
+	assert (status == 0);
+	status = blake2b_final (&state, result.bytes.data (), sizeof (result.bytes));
 	assert (status == 0);
 	return result;
 }
 
+rai::block_hash rai::block::hash () const
+{
+	rai::uint256_union result;
+	if (cached_state.load (std::memory_order_acquire) == hash_state::cached)
+	{
+		result = cached_hash;
+	}
+	else
+	{
+		blake2b_state hash_l;
+		auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
+		assert (status == 0);
+		hash (hash_l);
+		status = blake2b_final (&hash_l, result.bytes.data (), sizeof (result.bytes));
+		assert (status == 0);
+		auto expected (hash_state::empty);
+		if (cached_state.compare_exchange_strong (expected, hash_state::storing, std::memory_order_acquire))
+		{
+			cached_hash = result;
+			cached_state.store (hash_state::cached, std::memory_order_release);
+		}
+	}
+	return result;
+}
+
+void rai::block::refresh ()
+{
+	cached_state.store (hash_state::empty, std::memory_order_release);
+}
+
 void rai::send_block::visit (rai::block_visitor & visitor_a) const
 {
 	visitor_a.send_block (*this);
@@ -191,6 +258,7 @@ bool rai::send_block::deserialize (rai::stream & stream_a)
 			}
 		}
 	}
+	refresh ();
 	return error;
 }
 
@@ -227,6 +295,7 @@ bool rai::send_block::deserialize_json (boost::property_tree::ptree const & tree
 	{
 		error = true;
 	}
+	refresh ();
 	return error;
 }
 
@@ -501,6 +570,7 @@ bool rai::open_block::deserialize (rai::stream & stream_a)
 			}
 		}
 	}
+	refresh ();
 	return error;
 }
 
@@ -537,6 +607,7 @@ bool rai::open_block::deserialize_json (boost::property_tree::ptree const & tree
 	{
 		error = true;
 	}
+	refresh ();
 	return error;
 }
 
@@ -729,6 +800,7 @@ bool rai::change_block::deserialize (rai::stream & stream_a)
 			}
 		}
 	}
+	refresh ();
 	return error;
 }
 
@@ -760,6 +832,7 @@ bool rai::change_block::deserialize_json (boost::property_tree::ptree const & tr
 	{
 		error = true;
 	}
+	refresh ();
 	return error;
 }
 
@@ -1026,6 +1099,7 @@ bool rai::state_block::deserialize (rai::stream & stream_a)
 			}
 		}
 	}
+	refresh ();
 	return error;
 }
 
@@ -1072,6 +1146,7 @@ bool rai::state_block::deserialize_json (boost::property_tree::ptree const & tre
 	{
 		error = true;
 	}
+	refresh ();
 	return error;
 }
 
@@ -1257,6 +1332,68 @@ std::unique_ptr<rai::block> rai::deserialize_block (rai::stream & stream_a, rai:
 	return result;
 }
 
+std::shared_ptr<rai::block> rai::deserialize_block_shared (rai::stream & stream_a, rai::block_type type_a, rai::block_uniquer * uniquer_a)
+{
+	std::shared_ptr<rai::block> result;
+	auto error (false);
+	switch (type_a)
+	{
+		case rai::block_type::receive:
+			result = std::make_shared<rai::receive_block> (error, stream_a);
+			break;
+		case rai::block_type::send:
+			result = std::make_shared<rai::send_block> (error, stream_a);
+			break;
+		case rai::block_type::open:
+			result = std::make_shared<rai::open_block> (error, stream_a);
+			break;
+		case rai::block_type::change:
+			result = std::make_shared<rai::change_block> (error, stream_a);
+			break;
+		case rai::block_type::state:
+			result = std::make_shared<rai::state_block> (error, stream_a);
+			break;
+		default:
+			error = true;
+			break;
+	}
+	if (error)
+	{
+		result = nullptr;
+	}
+	else if (uniquer_a != nullptr)
+	{
+		result = uniquer_a->unique (result);
+	}
+	return result;
+}
+
+size_t rai::block_size (rai::block_type type_a)
+{
+	size_t result (0);
+	switch (type_a)
+	{
+		case rai::block_type::send:
+			result = rai::send_block::size;
+			break;
+		case rai::block_type::receive:
+			result = rai::receive_block::size;
+			break;
+		case rai::block_type::open:
+			result = rai::open_block::size;
+			break;
+		case rai::block_type::change:
+			result = rai::change_block::size;
+			break;
+		case rai::block_type::state:
+			result = rai::state_block::size;
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
 void rai::receive_block::visit (rai::block_visitor & visitor_a) const
 {
 	visitor_a.receive_block (*this);
@@ -1284,6 +1421,7 @@ bool rai::receive_block::deserialize (rai::stream & stream_a)
 			}
 		}
 	}
+	refresh ();
 	return error;
 }
 
@@ -1315,6 +1453,7 @@ bool rai::receive_block::deserialize_json (boost::property_tree::ptree const & t
 	{
 		error = true;
 	}
+	refresh ();
 	return error;
 }
 
@@ -1498,3 +1637,58 @@ void rai::receive_hashables::hash (blake2b_state & hash_a) const
 	blake2b_update (&hash_a, previous.bytes.data (), sizeof (previous.bytes));
 	blake2b_update (&hash_a, source.bytes.data (), sizeof (source.bytes));
 }
+
+size_t constexpr rai::block_uniquer::cleanup_buckets;
+
+rai::block_uniquer::block_uniquer () :
+cleanup_bucket (0)
+{
+}
+
+std::shared_ptr<rai::block> rai::block_uniquer::unique (std::shared_ptr<rai::block> block_a)
+{
+	auto result (block_a);
+	if (result != nullptr)
+	{
+		auto hash (block_a->full_hash ());
+		std::lock_guard<std::mutex> lock (mutex);
+		auto & existing (blocks[hash]);
+		auto block_l (existing.lock ());
+		if (block_l != nullptr)
+		{
+			result = block_l;
+		}
+		else
+		{
+			existing = block_a;
+		}
+		cleanup ();
+	}
+	return result;
+}
+
+void rai::block_uniquer::cleanup ()
+{
+	for (size_t i (0); i < cleanup_buckets; ++i)
+	{
+		cleanup_bucket = (cleanup_bucket + 1) % blocks.bucket_count ();
+		std::vector<rai::block_hash> expired;
+		for (auto j (blocks.begin (cleanup_bucket)), n (blocks.end (cleanup_bucket)); j != n; ++j)
+		{
+			if (j->second.expired ())
+			{
+				expired.push_back (j->first);
+			}
+		}
+		for (auto & hash : expired)
+		{
+			blocks.erase (hash);
+		}
+	}
+}
+
+size_t rai::block_uniquer::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return blocks.size ();
+}
@@ -5,7 +5,11 @@
 #include <assert.h>
 #include <blake2/blake2.h>
 #include <boost/property_tree/json_parser.hpp>
+
+#include <atomic>
+#include <mutex>
 #include <streambuf>
+#include <unordered_map>
 
 namespace rai
 {
@@ -42,8 +46,15 @@ enum class block_type : uint8_t
 class block
 {
 public:
-	// Return a digest of the hashables in this block.
+	block ();
+	block (rai::block const &);
+	rai::block & operator= (rai::block const &);
+	// Return a digest of the hashables in this block, computed on first use and cached.
 	rai::block_hash hash () const;
+	// Discard the cached digest, required after modifying hashables in place.
+	void refresh ();
+	// Digest of the hash, signature and work, two blocks with the same full hash are identical on the wire
+	rai::block_hash full_hash () const;
 	std::string to_json ();
 	virtual void hash (blake2b_state &) const = 0;
 	virtual uint64_t block_work () const = 0;
@@ -64,6 +75,17 @@ public:
 	virtual void signature_set (rai::uint512_union const &) = 0;
 	virtual ~block () = default;
 	virtual bool valid_predecessor (rai::block const &) const = 0;
+
+private:
+	enum class hash_state : uint8_t
+	{
+		empty,
+		storing,
+		cached
+	};
+	// Only the thread that moves the state from empty to storing writes cached_hash, concurrent callers compute their own copy until then
+	mutable std::atomic<hash_state> cached_state;
+	mutable rai::block_hash cached_hash;
 };
 class send_hashables
 {
@@ -295,8 +317,31 @@ public:
 	virtual void state_block (rai::state_block const &) = 0;
 	virtual ~block_visitor () = default;
 };
+// Interns live blocks by full hash so copies of the same block arriving from different peers share one object
+// The signature and work are part of the key so a copy carrying a bad signature can't stand in for the real block
+class block_uniquer
+{
+public:
+	block_uniquer ();
+	// Returns the live block with the same full hash if there is one, otherwise remembers and returns block_a
+	std::shared_ptr<rai::block> unique (std::shared_ptr<rai::block>);
+	size_t size ();
+
+private:
+	void cleanup ();
+	std::mutex mutex;
+	std::unordered_map<rai::block_hash, std::weak_ptr<rai::block>> blocks;
+	// Expired entries are swept a few buckets at a time as new blocks are added
+	size_t cleanup_bucket;
+	static size_t constexpr cleanup_buckets = 2;
+};
 std::unique_ptr<rai::block> deserialize_block (rai::stream &);
 std::unique_ptr<rai::block> deserialize_block (rai::stream &, rai::block_type);
+// Object and reference count share one allocation, used where the block is immediately shared
+// If a uniquer is given the live copy of an identical block is returned instead
+std::shared_ptr<rai::block> deserialize_block_shared (rai::stream &, rai::block_type, rai::block_uniquer * = nullptr);
+// Serialized size of a block type, 0 for types without a serialized form
+size_t block_size (rai::block_type);
 std::unique_ptr<rai::block> deserialize_block_json (boost::property_tree::ptree const &);
 void serialize_block (rai::stream &, rai::block const &);
 }
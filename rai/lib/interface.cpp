@@ -140,6 +140,7 @@ char * xrb_work_transaction (const char * transaction)
 }
 
 #include <ed25519-donna/ed25519-hash-custom.h>
+// Batch verification runs on the checker, block verification and vote threads at once, rai::random_pool is thread_local so each draws from its own generator
 void ed25519_randombytes_unsafe (void * out, size_t outlen)
 {
 	rai::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (out), outlen);
@@ -435,6 +435,12 @@ bool rai::validate_message (rai::public_key const & public_key, rai::uint256_uni
 	return result;
 }
 
+bool rai::validate_message_batch (unsigned char const ** m, size_t * mlen, unsigned char const ** pk, unsigned char const ** RS, size_t num, int * valid)
+{
+	auto result (0 != ed25519_sign_open_batch (m, mlen, pk, RS, num, valid));
+	return result;
+}
+
 rai::uint128_union::uint128_union (std::string const & string_a)
 {
 	decode_hex (string_a);
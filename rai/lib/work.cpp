@@ -3,6 +3,8 @@
 #include <rai/lib/blocks.hpp>
 #include <rai/node/xorshift.hpp>
 
+#include <boost/endian/conversion.hpp>
+
 #include <future>
 
 bool rai::work_validate (rai::block_hash const & root_a, uint64_t work_a)
@@ -15,6 +17,42 @@ bool rai::work_validate (rai::block const & block_a)
 	return work_validate (block_a.root (), block_a.block_work ());
 }
 
+bool rai::work_validate (rai::block_type type_a, uint8_t const * data_a, size_t size_a)
+{
+	auto result (true);
+	auto size (rai::block_size (type_a));
+	if (size != 0 && size == size_a)
+	{
+		rai::block_hash root;
+		uint64_t work;
+		std::copy (data_a + size - sizeof (work), data_a + size, reinterpret_cast<uint8_t *> (&work));
+		switch (type_a)
+		{
+			case rai::block_type::open:
+				// Open blocks are rooted on the account, serialized after source and representative
+				std::copy_n (data_a + sizeof (rai::block_hash) + sizeof (rai::account), root.bytes.size (), root.bytes.begin ());
+				break;
+			case rai::block_type::state:
+			{
+				// State blocks are rooted on previous, or on the account when previous is zero
+				std::copy_n (data_a + sizeof (rai::account), root.bytes.size (), root.bytes.begin ());
+				if (root.is_zero ())
+				{
+					std::copy_n (data_a, root.bytes.size (), root.bytes.begin ());
+				}
+				work = boost::endian::big_to_native (work);
+				break;
+			}
+			default:
+				// Send, receive and change blocks start with previous
+				std::copy_n (data_a, root.bytes.size (), root.bytes.begin ());
+				break;
+		}
+		result = work_validate (root, work);
+	}
+	return result;
+}
+
 uint64_t rai::work_value (rai::block_hash const & root_a, uint64_t work_a)
 {
 	uint64_t result;
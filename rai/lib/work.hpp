@@ -13,8 +13,11 @@
 namespace rai
 {
 class block;
+enum class block_type : uint8_t;
 bool work_validate (rai::block_hash const &, uint64_t);
 bool work_validate (rai::block const &);
+// Validates work on a block still in its serialized form, true if the work is insufficient or the size doesn't match the type
+bool work_validate (rai::block_type, uint8_t const *, size_t);
 uint64_t work_value (rai::block_hash const &, uint64_t);
 class opencl_work;
 class work_pool
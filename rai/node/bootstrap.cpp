@@ -526,7 +526,7 @@ void rai::bulk_pull_client::received_block (boost::system::error_code const & ec
 	if (!ec)
 	{
 		rai::bufferstream stream (connection->receive_buffer->data (), size_a);
-		std::shared_ptr<rai::block> block (rai::deserialize_block (stream, type_a));
+		auto block (rai::deserialize_block_shared (stream, type_a, &connection->node->block_uniquer));
 		if (block != nullptr && !rai::work_validate (*block))
 		{
 			auto hash (block->hash ());
@@ -545,7 +545,7 @@ void rai::bulk_pull_client::received_block (boost::system::error_code const & ec
 				connection->start_time = std::chrono::steady_clock::now ();
 			}
 			connection->attempt->total_blocks++;
-			connection->attempt->node->block_processor.add (block, std::chrono::steady_clock::time_point ());
+			connection->attempt->node->block_processor.add (block, std::chrono::steady_clock::time_point (), rai::block_origin::bootstrap, std::hash<rai::bootstrap_client *> () (connection.get ()));
 			if (!connection->hard_stop.load ())
 			{
 				receive_block ();
@@ -2112,7 +2112,7 @@ void rai::bulk_pull_blocks_server::set_params ()
 		BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull of block range starting, min (%1%) to max (%2%), max_count = %3%, mode = %4%") % request->min_hash.to_string () % request->max_hash.to_string () % request->max_count % modeName);
 	}
 
-	stream = connection->node->store.block_info_begin (stream_transaction, request->min_hash);
+	stream = connection->node->store.block_begin (stream_transaction, request->min_hash);
 
 	if (request->max_hash < request->min_hash)
 	{
@@ -2366,10 +2366,10 @@ void rai::bulk_push_server::received_block (boost::system::error_code const & ec
 	if (!ec)
 	{
 		rai::bufferstream stream (receive_buffer->data (), size_a);
-		auto block (rai::deserialize_block (stream, type_a));
+		auto block (rai::deserialize_block_shared (stream, type_a, &connection->node->block_uniquer));
 		if (block != nullptr && !rai::work_validate (*block))
 		{
-			connection->node->process_active (std::move (block));
+			connection->node->process_active (block, rai::block_origin::bootstrap, std::hash<rai::bootstrap_server *> () (connection.get ()));
 			receive ();
 		}
 		else
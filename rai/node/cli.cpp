@@ -406,7 +406,14 @@ std::error_code rai::handle_node_options (boost::program_options::variables_map
 		rai::keypair key;
 		std::cout << key.pub.to_string () << std::endl;
 		auto wallet (node.node->wallets.create (key.pub));
-		wallet->enter_initial_password ();
+		if (wallet != nullptr)
+		{
+			wallet->enter_initial_password ();
+		}
+		else
+		{
+			std::cerr << "Wallets can't be created with a volatile store\n";
+		}
 	}
 	else if (vm.count ("wallet_decrypt_unsafe"))
 	{
@@ -87,7 +87,66 @@ void rai::message_header::ipv4_only_set (bool value_a)
 // MTU - IP header - UDP header
 const size_t rai::message_parser::max_safe_udp_message_size = 508;
 
-rai::message_parser::message_parser (rai::message_visitor & visitor_a, rai::work_pool & pool_a) :
+rai::message_filter::message_filter (size_t size_a) :
+items (size_a)
+{
+	// A random seed keeps peers from crafting messages that evict each other
+	rai::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (&seed), sizeof (seed));
+}
+
+uint64_t rai::message_filter::digest (rai::message_header const & header_a, uint8_t const * data_a, size_t size_a) const
+{
+	// Version fields differ between peers relaying the same message so only the type, extensions and payload are hashed
+	XXH64_state_t hash;
+	XXH64_reset (&hash, seed);
+	XXH64_update (&hash, &header_a.type, sizeof (header_a.type));
+	auto extensions (static_cast<uint16_t> (header_a.extensions.to_ullong ()));
+	XXH64_update (&hash, &extensions, sizeof (extensions));
+	XXH64_update (&hash, data_a, size_a);
+	auto result (XXH64_digest (&hash));
+	// Zero marks an empty slot
+	return result != 0 ? result : 1;
+}
+
+uint64_t rai::message_filter::digest (std::shared_ptr<rai::block> block_a) const
+{
+	rai::publish message (block_a);
+	std::vector<uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		block_a->serialize (stream);
+	}
+	return digest (message.header, bytes.data (), bytes.size ());
+}
+
+bool rai::message_filter::apply (uint8_t const * data_a, size_t size_a, uint64_t * digest_a)
+{
+	auto result (false);
+	auto error (false);
+	rai::bufferstream stream (data_a, size_a);
+	rai::message_header header (error, stream);
+	if (!error && (header.type == rai::message_type::publish || header.type == rai::message_type::confirm_ack))
+	{
+		auto offset (size_a - stream.in_avail ());
+		auto digest_l (digest (header, data_a + offset, size_a - offset));
+		result = items[digest_l % items.size ()].exchange (digest_l) == digest_l;
+		if (digest_a != nullptr)
+		{
+			*digest_a = digest_l;
+		}
+	}
+	return result;
+}
+
+void rai::message_filter::clear (uint64_t digest_a)
+{
+	// Only the slot's own digest is cleared, a newer colliding digest stays
+	auto expected (digest_a);
+	items[digest_a % items.size ()].compare_exchange_strong (expected, 0);
+}
+
+rai::message_parser::message_parser (rai::block_uniquer & block_uniquer_a, rai::message_visitor & visitor_a, rai::work_pool & pool_a) :
+block_uniquer (block_uniquer_a),
 visitor (visitor_a),
 pool (pool_a),
 status (parse_status::success)
@@ -111,6 +170,9 @@ void rai::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t s
 			}
 			else
 			{
+				// Work is checked on the wire bytes so messages with insufficient work never allocate blocks or votes
+				size_t payload_size (stream.in_avail ());
+				auto payload (buffer_a + size_a - payload_size);
 				switch (header.type)
 				{
 					case rai::message_type::keepalive:
@@ -120,17 +182,31 @@ void rai::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t s
 					}
 					case rai::message_type::publish:
 					{
-						deserialize_publish (stream, header);
+						if (!validate_work (header.block_type (), payload, payload_size, parse_status::invalid_publish_message))
+						{
+							deserialize_publish (stream, header);
+						}
 						break;
 					}
 					case rai::message_type::confirm_req:
 					{
-						deserialize_confirm_req (stream, header);
+						if (header.block_type () == rai::block_type::not_a_block || !validate_work (header.block_type (), payload, payload_size, parse_status::invalid_confirm_req_message))
+						{
+							deserialize_confirm_req (stream, header);
+						}
 						break;
 					}
 					case rai::message_type::confirm_ack:
 					{
-						deserialize_confirm_ack (stream, header);
+						auto vote_header_size (sizeof (rai::account) + sizeof (rai::signature) + sizeof (uint64_t));
+						if (header.block_type () == rai::block_type::not_a_block || (payload_size >= vote_header_size && !validate_work (header.block_type (), payload + vote_header_size, payload_size - vote_header_size, parse_status::invalid_confirm_ack_message)))
+						{
+							deserialize_confirm_ack (stream, header);
+						}
+						else if (status == parse_status::success)
+						{
+							status = parse_status::invalid_confirm_ack_message;
+						}
 						break;
 					}
 					case rai::message_type::node_id_handshake:
@@ -170,17 +246,10 @@ void rai::message_parser::deserialize_keepalive (rai::stream & stream_a, rai::me
 void rai::message_parser::deserialize_publish (rai::stream & stream_a, rai::message_header const & header_a)
 {
 	auto error (false);
-	rai::publish incoming (error, stream_a, header_a);
+	rai::publish incoming (error, stream_a, header_a, &block_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		if (!rai::work_validate (*incoming.block))
-		{
-			visitor.publish (incoming);
-		}
-		else
-		{
-			status = parse_status::insufficient_work;
-		}
+		visitor.publish (incoming);
 	}
 	else
 	{
@@ -191,17 +260,10 @@ void rai::message_parser::deserialize_publish (rai::stream & stream_a, rai::mess
 void rai::message_parser::deserialize_confirm_req (rai::stream & stream_a, rai::message_header const & header_a)
 {
 	auto error (false);
-	rai::confirm_req incoming (error, stream_a, header_a);
+	rai::confirm_req incoming (error, stream_a, header_a, &block_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		if (!rai::work_validate (*incoming.block))
-		{
-			visitor.confirm_req (incoming);
-		}
-		else
-		{
-			status = parse_status::insufficient_work;
-		}
+		visitor.confirm_req (incoming);
 	}
 	else
 	{
@@ -212,25 +274,10 @@ void rai::message_parser::deserialize_confirm_req (rai::stream & stream_a, rai::
 void rai::message_parser::deserialize_confirm_ack (rai::stream & stream_a, rai::message_header const & header_a)
 {
 	auto error (false);
-	rai::confirm_ack incoming (error, stream_a, header_a);
+	rai::confirm_ack incoming (error, stream_a, header_a, &block_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		for (auto & vote_block : incoming.vote->blocks)
-		{
-			if (!vote_block.which ())
-			{
-				auto block (boost::get<std::shared_ptr<rai::block>> (vote_block));
-				if (rai::work_validate (*block))
-				{
-					status = parse_status::insufficient_work;
-					break;
-				}
-			}
-		}
-		if (status == parse_status::success)
-		{
-			visitor.confirm_ack (incoming);
-		}
+		visitor.confirm_ack (incoming);
 	}
 	else
 	{
@@ -252,6 +299,28 @@ void rai::message_parser::deserialize_node_id_handshake (rai::stream & stream_a,
 	}
 }
 
+bool rai::message_parser::validate_work (rai::block_type type_a, uint8_t const * data_a, size_t size_a, parse_status invalid_a)
+{
+	auto block_size (rai::block_size (type_a));
+	auto result (block_size == 0 || size_a % block_size != 0);
+	if (!result)
+	{
+		for (size_t offset (0); !result && offset < size_a; offset += block_size)
+		{
+			result = rai::work_validate (type_a, data_a + offset, block_size);
+		}
+		if (result)
+		{
+			status = parse_status::insufficient_work;
+		}
+	}
+	else
+	{
+		status = invalid_a;
+	}
+	return result;
+}
+
 bool rai::message_parser::at_end (rai::stream & stream_a)
 {
 	uint8_t junk;
@@ -320,12 +389,12 @@ bool rai::keepalive::operator== (rai::keepalive const & other_a) const
 	return peers == other_a.peers;
 }
 
-rai::publish::publish (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a) :
+rai::publish::publish (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a, rai::block_uniquer * uniquer_a) :
 message (header_a)
 {
 	if (!error_a)
 	{
-		error_a = deserialize (stream_a);
+		error_a = deserialize (stream_a, uniquer_a);
 	}
 }
 
@@ -337,9 +406,14 @@ block (block_a)
 }
 
 bool rai::publish::deserialize (rai::stream & stream_a)
+{
+	return deserialize (stream_a, nullptr);
+}
+
+bool rai::publish::deserialize (rai::stream & stream_a, rai::block_uniquer * uniquer_a)
 {
 	assert (header.type == rai::message_type::publish);
-	block = rai::deserialize_block (stream_a, header.block_type ());
+	block = rai::deserialize_block_shared (stream_a, header.block_type (), uniquer_a);
 	auto result (block == nullptr);
 	return result;
 }
@@ -361,12 +435,12 @@ bool rai::publish::operator== (rai::publish const & other_a) const
 	return *block == *other_a.block;
 }
 
-rai::confirm_req::confirm_req (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a) :
+rai::confirm_req::confirm_req (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a, rai::block_uniquer * uniquer_a) :
 message (header_a)
 {
 	if (!error_a)
 	{
-		error_a = deserialize (stream_a);
+		error_a = deserialize (stream_a, uniquer_a);
 	}
 }
 
@@ -377,11 +451,47 @@ block (block_a)
 	header.block_type_set (block->type ());
 }
 
+rai::confirm_req::confirm_req (std::vector<std::pair<rai::block_hash, rai::block_hash>> const & roots_hashes_a) :
+message (rai::message_type::confirm_req),
+roots_hashes (roots_hashes_a)
+{
+	assert (!roots_hashes.empty () && roots_hashes.size () <= roots_max);
+	header.block_type_set (rai::block_type::not_a_block);
+}
+
 bool rai::confirm_req::deserialize (rai::stream & stream_a)
+{
+	return deserialize (stream_a, nullptr);
+}
+
+bool rai::confirm_req::deserialize (rai::stream & stream_a, rai::block_uniquer * uniquer_a)
 {
 	assert (header.type == rai::message_type::confirm_req);
-	block = rai::deserialize_block (stream_a, header.block_type ());
-	auto result (block == nullptr);
+	auto result (false);
+	if (header.block_type () == rai::block_type::not_a_block)
+	{
+		// Pairs follow until the end of the message
+		while (!result && roots_hashes.size () < roots_max)
+		{
+			rai::block_hash hash;
+			if (rai::read (stream_a, hash))
+			{
+				break;
+			}
+			rai::block_hash root;
+			result = rai::read (stream_a, root);
+			if (!result)
+			{
+				roots_hashes.push_back (std::make_pair (hash, root));
+			}
+		}
+		result = result || roots_hashes.empty ();
+	}
+	else
+	{
+		block = rai::deserialize_block_shared (stream_a, header.block_type (), uniquer_a);
+		result = block == nullptr;
+	}
 	return result;
 }
 
@@ -392,19 +502,56 @@ void rai::confirm_req::visit (rai::message_visitor & visitor_a) const
 
 void rai::confirm_req::serialize (rai::stream & stream_a)
 {
-	assert (block != nullptr);
 	header.serialize (stream_a);
-	block->serialize (stream_a);
+	if (header.block_type () == rai::block_type::not_a_block)
+	{
+		assert (!roots_hashes.empty ());
+		for (auto & root_hash : roots_hashes)
+		{
+			write (stream_a, root_hash.first);
+			write (stream_a, root_hash.second);
+		}
+	}
+	else
+	{
+		assert (block != nullptr);
+		block->serialize (stream_a);
+	}
 }
 
 bool rai::confirm_req::operator== (rai::confirm_req const & other_a) const
 {
-	return *block == *other_a.block;
+	auto result (false);
+	if (block != nullptr && other_a.block != nullptr)
+	{
+		result = *block == *other_a.block;
+	}
+	else if (block == nullptr && other_a.block == nullptr)
+	{
+		result = roots_hashes == other_a.roots_hashes;
+	}
+	return result;
 }
 
-rai::confirm_ack::confirm_ack (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a) :
+std::string rai::confirm_req::roots_string () const
+{
+	std::string result;
+	for (auto & root_hash : roots_hashes)
+	{
+		result += root_hash.first.to_string ();
+		result += ":";
+		result += root_hash.second.to_string ();
+		result += ", ";
+	}
+	return result;
+}
+
+size_t constexpr rai::confirm_req::roots_max;
+size_t constexpr rai::confirm_ack::hashes_max;
+
+rai::confirm_ack::confirm_ack (bool & error_a, rai::stream & stream_a, rai::message_header const & header_a, rai::block_uniquer * uniquer_a) :
 message (header_a),
-vote (std::make_shared<rai::vote> (error_a, stream_a, header.block_type ()))
+vote (std::make_shared<rai::vote> (error_a, stream_a, header.block_type (), uniquer_a))
 {
 }
 
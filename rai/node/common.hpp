@@ -5,6 +5,7 @@
 
 #include <boost/asio.hpp>
 
+#include <atomic>
 #include <bitset>
 
 #include <xxhash/xxhash.h>
@@ -186,6 +187,24 @@ public:
 	virtual void visit (rai::message_visitor &) const = 0;
 	rai::message_header header;
 };
+// Remembers digests of recently received publish and confirm_ack messages so exact copies from other peers are dropped before they're deserialized
+class message_filter
+{
+public:
+	message_filter (size_t);
+	// Returns true if an identical message was seen recently, the digest is written out for publish and confirm_ack messages
+	bool apply (uint8_t const *, size_t, uint64_t * = nullptr);
+	// Forgets a digest so the next copy of that message is let through
+	void clear (uint64_t);
+	// Digest a publish message carrying this block would have
+	uint64_t digest (std::shared_ptr<rai::block>) const;
+
+private:
+	uint64_t digest (rai::message_header const &, uint8_t const *, size_t) const;
+	uint64_t seed;
+	// Each digest is stored at its own index modulo size, a colliding digest evicts the older one
+	std::vector<std::atomic<uint64_t>> items;
+};
 class work_pool;
 class message_parser
 {
@@ -203,14 +222,17 @@ public:
 		invalid_node_id_handshake_message,
 		outdated_version
 	};
-	message_parser (rai::message_visitor &, rai::work_pool &);
+	message_parser (rai::block_uniquer &, rai::message_visitor &, rai::work_pool &);
 	void deserialize_buffer (uint8_t const *, size_t);
 	void deserialize_keepalive (rai::stream &, rai::message_header const &);
 	void deserialize_publish (rai::stream &, rai::message_header const &);
 	void deserialize_confirm_req (rai::stream &, rai::message_header const &);
 	void deserialize_confirm_ack (rai::stream &, rai::message_header const &);
 	void deserialize_node_id_handshake (rai::stream &, rai::message_header const &);
+	// Checks work on consecutive serialized blocks of one type, sets status and returns true if the message should be dropped
+	bool validate_work (rai::block_type, uint8_t const *, size_t, parse_status);
 	bool at_end (rai::stream &);
+	rai::block_uniquer & block_uniquer;
 	rai::message_visitor & visitor;
 	rai::work_pool & pool;
 	parse_status status;
@@ -230,10 +252,11 @@ public:
 class publish : public message
 {
 public:
-	publish (bool &, rai::stream &, rai::message_header const &);
+	publish (bool &, rai::stream &, rai::message_header const &, rai::block_uniquer * = nullptr);
 	publish (std::shared_ptr<rai::block>);
 	void visit (rai::message_visitor &) const override;
 	bool deserialize (rai::stream &) override;
+	bool deserialize (rai::stream &, rai::block_uniquer *);
 	void serialize (rai::stream &) override;
 	bool operator== (rai::publish const &) const;
 	std::shared_ptr<rai::block> block;
@@ -241,24 +264,35 @@ public:
 class confirm_req : public message
 {
 public:
-	confirm_req (bool &, rai::stream &, rai::message_header const &);
+	confirm_req (bool &, rai::stream &, rai::message_header const &, rai::block_uniquer * = nullptr);
 	confirm_req (std::shared_ptr<rai::block>);
+	// Requests votes for several blocks by hash, the root lets a peer vote for the block it has in their place
+	confirm_req (std::vector<std::pair<rai::block_hash, rai::block_hash>> const &);
 	bool deserialize (rai::stream &) override;
+	bool deserialize (rai::stream &, rai::block_uniquer *);
 	void serialize (rai::stream &) override;
 	void visit (rai::message_visitor &) const override;
 	bool operator== (rai::confirm_req const &) const;
+	std::string roots_string () const;
+	// Null when the request is by hash
 	std::shared_ptr<rai::block> block;
+	// Hash and root pairs, the header block type is not_a_block
+	std::vector<std::pair<rai::block_hash, rai::block_hash>> roots_hashes;
+	// Most pairs in one request, keeps the message within max_safe_udp_message_size
+	static size_t constexpr roots_max = 7;
 };
 class confirm_ack : public message
 {
 public:
-	confirm_ack (bool &, rai::stream &, rai::message_header const &);
+	confirm_ack (bool &, rai::stream &, rai::message_header const &, rai::block_uniquer * = nullptr);
 	confirm_ack (std::shared_ptr<rai::vote>);
 	bool deserialize (rai::stream &) override;
 	void serialize (rai::stream &) override;
 	void visit (rai::message_visitor &) const override;
 	bool operator== (rai::confirm_ack const &) const;
 	std::shared_ptr<rai::vote> vote;
+	// Most hashes in a vote by hash, keeps the message within one datagram
+	static size_t constexpr hashes_max = 12;
 };
 class frontier_req : public message
 {
@@ -1,7 +1,9 @@
 
 #include <rai/node/lmdb.hpp>
 
-rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs)
+rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs, bool durable_a) :
+path (path_a),
+durable (durable_a)
 {
 	boost::system::error_code error;
 	if (path_a.has_parent_path ())
@@ -15,10 +17,13 @@ rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, i
 			assert (status2 == 0);
 			auto status3 (mdb_env_set_mapsize (environment, 1ULL * 1024 * 1024 * 1024 * 128)); // 128 Gigabyte
 			assert (status3 == 0);
+			auto status4 (mdb_env_set_maxreaders (environment, readers_max));
+			assert (status4 == 0);
 			// It seems if there's ever more threads than mdb_env_set_maxreaders has read slots available, we get failures on transaction creation unless MDB_NOTLS is specified
 			// This can happen if something like 256 io_threads are specified in the node config
-			auto status4 (mdb_env_open (environment, path_a.string ().c_str (), MDB_NOSUBDIR | MDB_NOTLS, 00600));
-			error_a = status4 != 0;
+			// Without syncing commits only reach the page cache, the file is scratch space for the memory map
+			auto status5 (mdb_env_open (environment, path_a.string ().c_str (), MDB_NOSUBDIR | MDB_NOTLS | (durable ? 0 : MDB_NOSYNC | MDB_NOMETASYNC), 00600));
+			error_a = status5 != 0;
 		}
 		else
 		{
@@ -33,11 +38,25 @@ rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, i
 	}
 }
 
+unsigned constexpr rai::mdb_env::readers_max;
+size_t constexpr rai::mdb_env::read_pool_max;
+std::chrono::seconds constexpr rai::mdb_env::read_age_max;
+
 rai::mdb_env::~mdb_env ()
 {
+	for (auto & i : read_pool)
+	{
+		mdb_txn_abort (i.first);
+	}
 	if (environment != nullptr)
 	{
 		mdb_env_close (environment);
+		if (!durable)
+		{
+			boost::system::error_code error;
+			boost::filesystem::remove (path, error);
+			boost::filesystem::remove (path.string () + "-lock", error);
+		}
 	}
 }
 
@@ -46,6 +65,77 @@ rai::mdb_env::operator MDB_env * () const
 	return environment;
 }
 
+MDB_txn * rai::mdb_env::read_begin (std::chrono::steady_clock::time_point & created_a)
+{
+	MDB_txn * result (nullptr);
+	{
+		std::lock_guard<std::mutex> lock (read_mutex);
+		if (!read_pool.empty ())
+		{
+			// Most recently returned first, its reader slot is the most likely to still be cached
+			result = read_pool.back ().first;
+			created_a = read_pool.back ().second;
+			read_pool.pop_back ();
+		}
+	}
+	if (result != nullptr)
+	{
+		auto status (mdb_txn_renew (result));
+		if (status != 0)
+		{
+			// The handle can't be reused, begin a fresh one in its place
+			mdb_txn_abort (result);
+			result = nullptr;
+		}
+	}
+	if (result == nullptr)
+	{
+		created_a = std::chrono::steady_clock::now ();
+		auto status (mdb_txn_begin (environment, nullptr, MDB_RDONLY, &result));
+		if (status == MDB_READERS_FULL)
+		{
+			// Idle pooled handles keep their reader slots, release them and try once more
+			read_pool_clear ();
+			status = mdb_txn_begin (environment, nullptr, MDB_RDONLY, &result);
+		}
+		if (status != 0)
+		{
+			throw std::runtime_error (mdb_strerror (status));
+		}
+	}
+	return result;
+}
+
+void rai::mdb_env::read_pool_clear ()
+{
+	std::lock_guard<std::mutex> lock (read_mutex);
+	for (auto & i : read_pool)
+	{
+		mdb_txn_abort (i.first);
+	}
+	read_pool.clear ();
+}
+
+void rai::mdb_env::read_end (MDB_txn * transaction_a, std::chrono::steady_clock::time_point const & created_a)
+{
+	// Reset releases the snapshot so idle transactions never hold back page reuse
+	mdb_txn_reset (transaction_a);
+	auto pooled (false);
+	if (std::chrono::steady_clock::now () - created_a < read_age_max)
+	{
+		std::lock_guard<std::mutex> lock (read_mutex);
+		if (read_pool.size () < read_pool_max)
+		{
+			read_pool.push_back (std::make_pair (transaction_a, created_a));
+			pooled = true;
+		}
+	}
+	if (!pooled)
+	{
+		mdb_txn_abort (transaction_a);
+	}
+}
+
 rai::mdb_val::mdb_val (rai::epoch epoch_a) :
 value ({ 0, nullptr }),
 epoch (epoch_a)
@@ -88,9 +178,34 @@ mdb_val (sizeof (val_a), const_cast<rai::pending_key *> (&val_a))
 {
 }
 
-rai::mdb_val::mdb_val (rai::block_info const & val_a) :
-mdb_val (sizeof (val_a), const_cast<rai::block_info *> (&val_a))
+rai::mdb_val::mdb_val (rai::unchecked_key const & val_a) :
+mdb_val (sizeof (val_a), const_cast<rai::unchecked_key *> (&val_a))
+{
+}
+
+rai::mdb_val::mdb_val (rai::delegator_key const & val_a) :
+mdb_val (sizeof (val_a), const_cast<rai::delegator_key *> (&val_a))
+{
+}
+
+rai::mdb_val::mdb_val (rai::height_key const & val_a) :
+buffer (std::make_shared<std::vector<uint8_t>> ())
+{
+	{
+		rai::vectorstream stream (*buffer);
+		val_a.serialize (stream);
+	}
+	value = { buffer->size (), const_cast<uint8_t *> (buffer->data ()) };
+}
+
+rai::mdb_val::mdb_val (rai::unchecked_info const & val_a) :
+buffer (std::make_shared<std::vector<uint8_t>> ())
 {
+	{
+		rai::vectorstream stream (*buffer);
+		val_a.serialize (stream);
+	}
+	value = { buffer->size (), const_cast<uint8_t *> (buffer->data ()) };
 }
 
 rai::mdb_val::mdb_val (rai::block const & val_a) :
@@ -122,15 +237,6 @@ rai::mdb_val::operator rai::account_info () const
 	return result;
 }
 
-rai::mdb_val::operator rai::block_info () const
-{
-	rai::block_info result;
-	assert (value.mv_size == sizeof (result));
-	static_assert (sizeof (rai::block_info::account) + sizeof (rai::block_info::balance) == sizeof (result), "Packed class");
-	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
-	return result;
-}
-
 rai::mdb_val::operator rai::pending_info () const
 {
 	rai::pending_info result;
@@ -148,6 +254,42 @@ rai::mdb_val::operator rai::pending_key () const
 	return result;
 }
 
+rai::mdb_val::operator rai::unchecked_key () const
+{
+	rai::unchecked_key result;
+	assert (value.mv_size == sizeof (result));
+	static_assert (sizeof (rai::unchecked_key::previous) + sizeof (rai::unchecked_key::hash) == sizeof (result), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
+	return result;
+}
+
+rai::mdb_val::operator rai::delegator_key () const
+{
+	rai::delegator_key result;
+	assert (value.mv_size == sizeof (result));
+	static_assert (sizeof (rai::delegator_key::representative) + sizeof (rai::delegator_key::account) == sizeof (result), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
+	return result;
+}
+
+rai::mdb_val::operator rai::height_key () const
+{
+	rai::height_key result;
+	rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+	auto error (result.deserialize (stream));
+	assert (!error);
+	return result;
+}
+
+rai::mdb_val::operator rai::unchecked_info () const
+{
+	rai::unchecked_info result;
+	rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+	auto error (result.deserialize (stream));
+	assert (!error);
+	return result;
+}
+
 rai::mdb_val::operator rai::uint128_union () const
 {
 	rai::uint128_union result;
@@ -191,16 +333,37 @@ rai::mdb_val::operator MDB_val const & () const
 }
 
 rai::transaction::transaction (rai::mdb_env & environment_a, MDB_txn * parent_a, bool write) :
-environment (environment_a)
+parent (parent_a),
+environment (environment_a),
+pooled (!write && parent_a == nullptr)
 {
-	auto status (mdb_txn_begin (environment_a, parent_a, write ? 0 : MDB_RDONLY, &handle));
-	assert (status == 0);
+	if (pooled)
+	{
+		handle = environment_a.read_begin (created);
+	}
+	else
+	{
+		auto status (mdb_txn_begin (environment_a, parent_a, write ? 0 : MDB_RDONLY, &handle));
+		assert (status == 0);
+	}
 }
 
 rai::transaction::~transaction ()
 {
-	auto status (mdb_txn_commit (handle));
-	assert (status == 0);
+	if (pooled)
+	{
+		environment.read_end (handle, created);
+	}
+	else
+	{
+		// LMDB hands the same handle to the next writer as soon as the commit releases the write lock
+		if (environment.commit_observer)
+		{
+			environment.commit_observer (handle, parent);
+		}
+		auto status (mdb_txn_commit (handle));
+		assert (status == 0);
+	}
 }
 
 rai::transaction::operator MDB_txn * () const
@@ -7,6 +7,11 @@
 #include <rai/lib/numbers.hpp>
 #include <rai/secure/common.hpp>
 
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+
 namespace rai
 {
 /**
@@ -15,10 +20,33 @@ namespace rai
 class mdb_env
 {
 public:
-	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128);
+	// Environments that aren't durable skip syncing to disk and delete their file when closed
+	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128, bool durable = true);
 	~mdb_env ();
 	operator MDB_env * () const;
+	// Renews a pooled read transaction or begins a new one, sets the time it was first begun
+	// Throws std::runtime_error if no read transaction can be begun
+	MDB_txn * read_begin (std::chrono::steady_clock::time_point &);
+	// Resets a read transaction and keeps it for the next reader
+	void read_end (MDB_txn *, std::chrono::steady_clock::time_point const &);
 	MDB_env * environment;
+	boost::filesystem::path path;
+	bool durable;
+	// Called with a transaction's handle and parent right before it commits, while the handle is still ours and the write lock held, lets in-memory copies publish what the transaction changed
+	std::function<void(MDB_txn *, MDB_txn *)> commit_observer;
+	// Reader slots in the lock file, enough for a full pool on top of a reader per busy thread
+	static unsigned constexpr readers_max = 512;
+	// Each pooled transaction holds a reader slot, at most this many are kept idle
+	static size_t constexpr read_pool_max = 32;
+	// Transactions are closed rather than pooled once they were first begun this long ago
+	static std::chrono::seconds constexpr read_age_max = std::chrono::seconds (60);
+
+private:
+	// Aborts every idle pooled transaction, freeing their reader slots
+	void read_pool_clear ();
+	std::mutex read_mutex;
+	// Reset read transactions and the time each was first begun
+	std::deque<std::pair<MDB_txn *, std::chrono::steady_clock::time_point>> read_pool;
 };
 
 /**
@@ -29,10 +57,13 @@ class mdb_val
 public:
 	mdb_val (rai::epoch = rai::epoch::unspecified);
 	mdb_val (rai::account_info const &);
-	mdb_val (rai::block_info const &);
 	mdb_val (MDB_val const &, rai::epoch = rai::epoch::unspecified);
 	mdb_val (rai::pending_info const &);
 	mdb_val (rai::pending_key const &);
+	mdb_val (rai::unchecked_key const &);
+	mdb_val (rai::delegator_key const &);
+	mdb_val (rai::height_key const &);
+	mdb_val (rai::unchecked_info const &);
 	mdb_val (size_t, void *);
 	mdb_val (rai::uint128_union const &);
 	mdb_val (rai::uint256_union const &);
@@ -40,9 +71,12 @@ public:
 	void * data () const;
 	size_t size () const;
 	explicit operator rai::account_info () const;
-	explicit operator rai::block_info () const;
 	explicit operator rai::pending_info () const;
 	explicit operator rai::pending_key () const;
+	explicit operator rai::unchecked_key () const;
+	explicit operator rai::delegator_key () const;
+	explicit operator rai::height_key () const;
+	explicit operator rai::unchecked_info () const;
 	explicit operator rai::uint128_union () const;
 	explicit operator rai::uint256_union () const;
 	explicit operator rai::vote () const;
@@ -65,7 +99,11 @@ public:
 	~transaction ();
 	operator MDB_txn * () const;
 	MDB_txn * handle;
+	MDB_txn * parent;
 	rai::mdb_env & environment;
+	// Top level read transactions come from and return to the environment's pool
+	bool pooled;
+	std::chrono::steady_clock::time_point created;
 };
 class block_store;
 /**
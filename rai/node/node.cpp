@@ -5,6 +5,7 @@
 #include <rai/node/rpc.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <future>
 #include <memory>
 #include <sstream>
@@ -28,12 +29,29 @@ double constexpr rai::node::free_cutoff;
 std::chrono::seconds constexpr rai::node::period;
 std::chrono::seconds constexpr rai::node::cutoff;
 std::chrono::seconds constexpr rai::node::syn_cookie_cutoff;
+size_t constexpr rai::network::udp_batch_size;
+size_t constexpr rai::network::publish_filter_size;
 std::chrono::minutes constexpr rai::node::backup_interval;
+size_t constexpr rai::node::unchecked_cleanup_batch;
+size_t constexpr rai::node::unchecked_cleanup_max;
 int constexpr rai::port_mapping::mapping_timeout;
 int constexpr rai::port_mapping::check_timeout;
 unsigned constexpr rai::active_transactions::announce_interval_ms;
+unsigned constexpr rai::active_transactions::announce_interval_min_ms;
+unsigned constexpr rai::active_transactions::announcements_per_interval;
+unsigned constexpr rai::active_transactions::announcement_min;
+unsigned constexpr rai::active_transactions::could_fit_intervals;
+size_t constexpr rai::active_transactions::shard_count;
 size_t constexpr rai::block_arrival::arrival_size_min;
 std::chrono::seconds constexpr rai::block_arrival::arrival_time_min;
+size_t constexpr rai::signature_checker::batch_size;
+size_t constexpr rai::block_processor::verification_max;
+size_t constexpr rai::block_processor::checked_max;
+size_t constexpr rai::block_processor::bootstrap_full;
+size_t constexpr rai::block_processor::batch_min;
+size_t constexpr rai::block_queue::live_max;
+size_t constexpr rai::block_queue::bootstrap_max;
+unsigned constexpr rai::block_queue::live_weight;
 
 rai::endpoint rai::map_endpoint_to_v6 (rai::endpoint const & endpoint_a)
 {
@@ -46,29 +64,100 @@ rai::endpoint rai::map_endpoint_to_v6 (rai::endpoint const & endpoint_a)
 }
 
 rai::network::network (rai::node & node_a, uint16_t port) :
-socket (node_a.service, rai::endpoint (boost::asio::ip::address_v6::any (), port)),
+socket (node_a.service),
 resolver (node_a.service),
 node (node_a),
-on (true)
-{
+on (true),
+batch_io (node_a.config.udp_batch_io && rai::udp_batch_supported ()),
+publish_filter (publish_filter_size),
+sending (false)
+{
+	rai::endpoint endpoint_l (boost::asio::ip::address_v6::any (), port);
+	if (node_a.config.udp_sockets > 1 && port != 0)
+	{
+		// Sockets sharing a port through SO_REUSEPORT don't conflict, bind once without it so a port owned by another process fails here instead of splitting its traffic
+		boost::asio::ip::udp::socket probe (node_a.service);
+		probe.open (endpoint_l.protocol ());
+		probe.bind (endpoint_l);
+	}
+	socket.open (endpoint_l.protocol ());
+	auto reuse (node_a.config.udp_sockets > 1 && !rai::udp_reuse_port (socket));
+	socket.bind (endpoint_l);
+	receivers.push_back (std::make_unique<rai::udp_receiver> (*this, socket, socket_mutex));
+	if (reuse)
+	{
+		// Bind to the port actually assigned in case an ephemeral one was requested
+		endpoint_l.port (socket.local_endpoint ().port ());
+		for (auto i (1); i < node_a.config.udp_sockets; ++i)
+		{
+			reuse_sockets.emplace_back (node_a.service);
+			auto & socket_l (reuse_sockets.back ());
+			boost::system::error_code ec;
+			socket_l.open (endpoint_l.protocol (), ec);
+			if (!ec && !rai::udp_reuse_port (socket_l))
+			{
+				socket_l.bind (endpoint_l, ec);
+			}
+			if (ec || !socket_l.is_open ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Unable to add UDP socket on port %1%: %2%") % endpoint_l.port () % ec.message ());
+				reuse_sockets.pop_back ();
+				break;
+			}
+			reuse_mutexes.emplace_back ();
+			receivers.push_back (std::make_unique<rai::udp_receiver> (*this, socket_l, reuse_mutexes.back ()));
+		}
+	}
 }
 
 void rai::network::receive ()
 {
-	if (node.config.logging.network_packet_logging ())
+	for (auto & receiver : receivers)
+	{
+		receiver->receive ();
+	}
+}
+
+rai::udp_receiver::udp_receiver (rai::network & network_a, boost::asio::ip::udp::socket & socket_a, std::mutex & socket_mutex_a) :
+network (network_a),
+socket (socket_a),
+socket_mutex (socket_mutex_a)
+{
+	if (network.batch_io)
 	{
-		BOOST_LOG (node.log) << "Receiving packet";
+		buffers.resize (rai::network::udp_batch_size);
+	}
+}
+
+void rai::udp_receiver::receive ()
+{
+	if (network.node.config.logging.network_packet_logging ())
+	{
+		BOOST_LOG (network.node.log) << "Receiving packet";
 	}
 	std::unique_lock<std::mutex> lock (socket_mutex);
-	socket.async_receive_from (boost::asio::buffer (buffer.data (), buffer.size ()), remote, [this](boost::system::error_code const & error, size_t size_a) {
-		receive_action (error, size_a);
-	});
+	if (network.batch_io)
+	{
+		socket.async_wait (boost::asio::ip::udp::socket::wait_read, [this](boost::system::error_code const & error) {
+			receive_batch_action (error);
+		});
+	}
+	else
+	{
+		socket.async_receive_from (boost::asio::buffer (buffer.data (), buffer.size ()), remote, [this](boost::system::error_code const & error, size_t size_a) {
+			receive_action (error, size_a);
+		});
+	}
 }
 
 void rai::network::stop ()
 {
 	on = false;
 	socket.close ();
+	for (auto & socket_l : reuse_sockets)
+	{
+		socket_l.close ();
+	}
 	resolver.cancel ();
 }
 
@@ -298,13 +387,71 @@ void rai::network::broadcast_confirm_req_base (std::shared_ptr<rai::block> block
 	}
 }
 
+void rai::network::broadcast_confirm_req_batch (std::shared_ptr<std::unordered_map<rai::endpoint, std::vector<std::pair<std::shared_ptr<rai::block>, bool>>>> requests_a, unsigned delay_a)
+{
+	const size_t max_reps = 10;
+	auto versions (node.peers.list_version ());
+	size_t count (0);
+	while (!requests_a->empty () && count < max_reps)
+	{
+		auto i (requests_a->begin ());
+		auto version (versions.find (i->first));
+		// Older peers only understand a single block per request
+		auto hashes (version != versions.end () && version->second >= rai::confirm_req_hashes_version);
+		std::vector<std::pair<rai::block_hash, rai::block_hash>> roots_hashes;
+		for (auto & block : i->second)
+		{
+			if (hashes && !block.second)
+			{
+				roots_hashes.push_back (std::make_pair (block.first->hash (), block.first->root ()));
+				if (roots_hashes.size () == rai::confirm_req::roots_max)
+				{
+					send_confirm_req_hashes (i->first, roots_hashes);
+					roots_hashes.clear ();
+				}
+			}
+			else
+			{
+				send_confirm_req (i->first, block.first);
+			}
+		}
+		if (!roots_hashes.empty ())
+		{
+			send_confirm_req_hashes (i->first, roots_hashes);
+		}
+		requests_a->erase (i);
+		++count;
+	}
+	if (!requests_a->empty ())
+	{
+		std::weak_ptr<rai::node> node_w (node.shared ());
+		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a), [node_w, requests_a, delay_a]() {
+			if (auto node_l = node_w.lock ())
+			{
+				node_l->network.broadcast_confirm_req_batch (requests_a, delay_a + 50);
+			}
+		});
+	}
+}
+
 void rai::network::send_confirm_req (rai::endpoint const & endpoint_a, std::shared_ptr<rai::block> block)
 {
 	rai::confirm_req message (block);
+	send_confirm_req (endpoint_a, message);
+}
+
+void rai::network::send_confirm_req_hashes (rai::endpoint const & endpoint_a, std::vector<std::pair<rai::block_hash, rai::block_hash>> const & roots_hashes_a)
+{
+	rai::confirm_req message (roots_hashes_a);
+	send_confirm_req (endpoint_a, message);
+}
+
+void rai::network::send_confirm_req (rai::endpoint const & endpoint_a, rai::confirm_req & message_a)
+{
 	std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
 	{
 		rai::vectorstream stream (*bytes);
-		message.serialize (stream);
+		message_a.serialize (stream);
 	}
 	if (node.config.logging.network_message_logging ())
 	{
@@ -389,24 +536,59 @@ public:
 		}
 		node.stats.inc (rai::stat::type::message, rai::stat::detail::publish, rai::stat::dir::in);
 		node.peers.contacted (sender, message_a.header.version_using);
-		node.process_active (message_a.block);
+		node.process_active (message_a.block, rai::block_origin::live, std::hash<rai::endpoint> () (sender));
 		node.active.publish (message_a.block);
 	}
 	void confirm_req (rai::confirm_req const & message_a) override
 	{
 		if (node.config.logging.network_message_logging ())
 		{
-			BOOST_LOG (node.log) << boost::str (boost::format ("Confirm_req message from %1% for %2%") % sender % message_a.block->hash ().to_string ());
+			BOOST_LOG (node.log) << boost::str (boost::format ("Confirm_req message from %1% for %2%") % sender % (message_a.block != nullptr ? message_a.block->hash ().to_string () : message_a.roots_string ()));
 		}
 		node.stats.inc (rai::stat::type::message, rai::stat::detail::confirm_req, rai::stat::dir::in);
 		node.peers.contacted (sender, message_a.header.version_using);
-		node.process_active (message_a.block);
-		node.active.publish (message_a.block);
-		rai::transaction transaction_a (node.store.environment, nullptr, false);
-		auto successor (node.ledger.successor (transaction_a, message_a.block->root ()));
-		if (successor != nullptr)
+		if (message_a.block != nullptr)
 		{
-			confirm_block (transaction_a, node, sender, std::move (successor));
+			node.process_active (message_a.block, rai::block_origin::live, std::hash<rai::endpoint> () (sender));
+			node.active.publish (message_a.block);
+			rai::transaction transaction_a (node.store.environment, nullptr, false);
+			auto successor (node.ledger.successor (transaction_a, message_a.block->root ()));
+			if (successor != nullptr)
+			{
+				if (std::chrono::system_clock::now () >= node.config.generate_hash_votes_at)
+				{
+					node.vote_generator.add (successor->hash (), sender);
+				}
+				else
+				{
+					confirm_block (transaction_a, node, sender, std::move (successor));
+				}
+			}
+		}
+		else
+		{
+			rai::transaction transaction_a (node.store.environment, nullptr, false);
+			for (auto & root_hash : message_a.roots_hashes)
+			{
+				// Vote for the requested block if it's in the ledger, otherwise for the block holding its root here
+				rai::block_hash hash (0);
+				if (node.store.block_exists (transaction_a, root_hash.first))
+				{
+					hash = root_hash.first;
+				}
+				else
+				{
+					auto successor (node.ledger.successor (transaction_a, root_hash.second));
+					if (successor != nullptr)
+					{
+						hash = successor->hash ();
+					}
+				}
+				if (!hash.is_zero ())
+				{
+					node.vote_generator.add (hash, sender);
+				}
+			}
 		}
 	}
 	void confirm_ack (rai::confirm_ack const & message_a) override
@@ -422,7 +604,7 @@ public:
 			if (!vote_block.which ())
 			{
 				auto block (boost::get<std::shared_ptr<rai::block>> (vote_block));
-				node.process_active (block);
+				node.process_active (block, rai::block_origin::live, std::hash<rai::endpoint> () (sender));
 				node.active.publish (block);
 			}
 		}
@@ -492,15 +674,71 @@ public:
 };
 }
 
-void rai::network::receive_action (boost::system::error_code const & error, size_t size_a)
+void rai::udp_receiver::receive_action (boost::system::error_code const & error, size_t size_a)
+{
+	if (!error && network.on)
+	{
+		network.process_datagram (buffer.data (), size_a, remote);
+		receive ();
+	}
+	else
+	{
+		if (error)
+		{
+			if (network.node.config.logging.network_logging ())
+			{
+				BOOST_LOG (network.node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+			}
+		}
+		if (network.on)
+		{
+			network.node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { receive (); });
+		}
+	}
+}
+
+void rai::udp_receiver::receive_batch_action (boost::system::error_code const & error)
+{
+	if (!error && network.on)
+	{
+		boost::system::error_code ec;
+		auto count (rai::udp_receive_batch (socket, buffers, ec));
+		for (size_t i (0); i < count; ++i)
+		{
+			auto & buffer_l (buffers[i]);
+			network.process_datagram (buffer_l.data.data (), buffer_l.size, buffer_l.endpoint);
+		}
+		if (ec && ec != boost::asio::error::would_block && network.node.config.logging.network_logging ())
+		{
+			BOOST_LOG (network.node.log) << boost::str (boost::format ("UDP Receive error: %1%") % ec.message ());
+		}
+		receive ();
+	}
+	else
+	{
+		if (error)
+		{
+			if (network.node.config.logging.network_logging ())
+			{
+				BOOST_LOG (network.node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+			}
+		}
+		if (network.on)
+		{
+			network.node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { receive (); });
+		}
+	}
+}
+
+void rai::network::process_datagram (uint8_t const * data_a, size_t size_a, rai::endpoint const & sender_a)
 {
-	if (!error && on)
+	if (!rai::reserved_address (sender_a, false) && sender_a != endpoint ())
 	{
-		if (!rai::reserved_address (remote, false) && remote != endpoint ())
+		if (!publish_filter.apply (data_a, size_a))
 		{
-			network_message_visitor visitor (node, remote);
-			rai::message_parser parser (visitor, node.work);
-			parser.deserialize_buffer (buffer.data (), size_a);
+			network_message_visitor visitor (node, sender_a);
+			rai::message_parser parser (node.block_uniquer, visitor, node.work);
+			parser.deserialize_buffer (data_a, size_a);
 			if (parser.status != rai::message_parser::parse_status::success)
 			{
 				node.stats.inc (rai::stat::type::error);
@@ -576,28 +814,17 @@ void rai::network::receive_action (boost::system::error_code const & error, size
 		}
 		else
 		{
-			if (node.config.logging.network_logging ())
-			{
-				BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % remote.address ().to_string ());
-			}
-
-			node.stats.inc_detail_only (rai::stat::type::error, rai::stat::detail::bad_sender);
+			node.stats.inc (rai::stat::type::filter, rai::stat::detail::duplicate_message);
 		}
-		receive ();
 	}
 	else
 	{
-		if (error)
-		{
-			if (node.config.logging.network_logging ())
-			{
-				BOOST_LOG (node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
-			}
-		}
-		if (on)
+		if (node.config.logging.network_logging ())
 		{
-			node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { receive (); });
+			BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % sender_a.address ().to_string ());
 		}
+
+		node.stats.inc_detail_only (rai::stat::type::error, rai::stat::detail::bad_sender);
 	}
 }
 
@@ -911,7 +1138,18 @@ enable_voting (true),
 bootstrap_connections (4),
 bootstrap_connections_max (64),
 callback_port (0),
-lmdb_max_dbs (128)
+lmdb_max_dbs (128),
+signature_checker_threads (std::max<unsigned> (1, std::thread::hardware_concurrency ()) - 1),
+udp_batch_io (true),
+udp_sockets (1),
+block_processor_batch_max (16 * 1024),
+block_processor_live_latency (std::chrono::milliseconds (100)),
+block_processor_bootstrap_latency (std::chrono::milliseconds (1000)),
+unchecked_cache_max (rai::block_store::unchecked_cache_max_default),
+unchecked_max (rai::block_store::unchecked_max_default),
+unchecked_cutoff (std::chrono::hours (4)),
+store_backend ("lmdb"),
+vote_generator_delay (std::chrono::milliseconds (0))
 {
 	const char * epoch_message ("epoch v1 block");
 	strncpy ((char *)epoch_block_link.bytes.data (), epoch_message, epoch_block_link.bytes.size ());
@@ -951,7 +1189,7 @@ lmdb_max_dbs (128)
 
 void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) const
 {
-	tree_a.put ("version", "14");
+	tree_a.put ("version", "21");
 	tree_a.put ("peering_port", std::to_string (peering_port));
 	tree_a.put ("bootstrap_fraction_numerator", std::to_string (bootstrap_fraction_numerator));
 	tree_a.put ("receive_minimum", receive_minimum.to_string_dec ());
@@ -995,6 +1233,17 @@ void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) con
 	tree_a.put ("callback_target", callback_target);
 	tree_a.put ("lmdb_max_dbs", lmdb_max_dbs);
 	tree_a.put ("generate_hash_votes_at", std::chrono::system_clock::to_time_t (generate_hash_votes_at));
+	tree_a.put ("signature_checker_threads", std::to_string (signature_checker_threads));
+	tree_a.put ("udp_batch_io", udp_batch_io);
+	tree_a.put ("udp_sockets", std::to_string (udp_sockets));
+	tree_a.put ("block_processor_batch_max", std::to_string (block_processor_batch_max));
+	tree_a.put ("block_processor_live_latency", std::to_string (block_processor_live_latency.count ()));
+	tree_a.put ("block_processor_bootstrap_latency", std::to_string (block_processor_bootstrap_latency.count ()));
+	tree_a.put ("unchecked_cache_max", std::to_string (unchecked_cache_max));
+	tree_a.put ("unchecked_max", std::to_string (unchecked_max));
+	tree_a.put ("unchecked_cutoff", std::to_string (unchecked_cutoff.count ()));
+	tree_a.put ("store_backend", store_backend);
+	tree_a.put ("vote_generator_delay", std::to_string (vote_generator_delay.count ()));
 }
 
 bool rai::node_config::upgrade_json (unsigned version, boost::property_tree::ptree & tree_a)
@@ -1102,6 +1351,45 @@ bool rai::node_config::upgrade_json (unsigned version, boost::property_tree::ptr
 			tree_a.put ("version", "14");
 			result = true;
 		case 14:
+			tree_a.put ("signature_checker_threads", std::to_string (signature_checker_threads));
+			tree_a.erase ("version");
+			tree_a.put ("version", "15");
+			result = true;
+		case 15:
+			tree_a.put ("udp_batch_io", udp_batch_io);
+			tree_a.erase ("version");
+			tree_a.put ("version", "16");
+			result = true;
+		case 16:
+			tree_a.put ("udp_sockets", std::to_string (udp_sockets));
+			tree_a.erase ("version");
+			tree_a.put ("version", "17");
+			result = true;
+		case 17:
+			tree_a.put ("block_processor_batch_max", std::to_string (block_processor_batch_max));
+			tree_a.put ("block_processor_live_latency", std::to_string (block_processor_live_latency.count ()));
+			tree_a.put ("block_processor_bootstrap_latency", std::to_string (block_processor_bootstrap_latency.count ()));
+			tree_a.erase ("version");
+			tree_a.put ("version", "18");
+			result = true;
+		case 18:
+			tree_a.put ("unchecked_cache_max", std::to_string (unchecked_cache_max));
+			tree_a.put ("unchecked_max", std::to_string (unchecked_max));
+			tree_a.put ("unchecked_cutoff", std::to_string (unchecked_cutoff.count ()));
+			tree_a.erase ("version");
+			tree_a.put ("version", "19");
+			result = true;
+		case 19:
+			tree_a.put ("store_backend", store_backend);
+			tree_a.erase ("version");
+			tree_a.put ("version", "20");
+			result = true;
+		case 20:
+			tree_a.put ("vote_generator_delay", std::to_string (vote_generator_delay.count ()));
+			tree_a.erase ("version");
+			tree_a.put ("version", "21");
+			result = true;
+		case 21:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -1189,6 +1477,17 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 		result |= parse_port (callback_port_l, callback_port);
 		auto generate_hash_votes_at_l = tree_a.get<time_t> ("generate_hash_votes_at");
 		generate_hash_votes_at = std::chrono::system_clock::from_time_t (generate_hash_votes_at_l);
+		auto signature_checker_threads_l (tree_a.get<std::string> ("signature_checker_threads"));
+		udp_batch_io = tree_a.get<bool> ("udp_batch_io");
+		auto udp_sockets_l (tree_a.get<std::string> ("udp_sockets"));
+		auto block_processor_batch_max_l (tree_a.get<std::string> ("block_processor_batch_max"));
+		auto block_processor_live_latency_l (tree_a.get<std::string> ("block_processor_live_latency"));
+		auto block_processor_bootstrap_latency_l (tree_a.get<std::string> ("block_processor_bootstrap_latency"));
+		auto unchecked_cache_max_l (tree_a.get<std::string> ("unchecked_cache_max"));
+		auto unchecked_max_l (tree_a.get<std::string> ("unchecked_max"));
+		auto unchecked_cutoff_l (tree_a.get<std::string> ("unchecked_cutoff"));
+		store_backend = tree_a.get<std::string> ("store_backend");
+		auto vote_generator_delay_l (tree_a.get<std::string> ("vote_generator_delay"));
 		try
 		{
 			peering_port = std::stoul (peering_port_l);
@@ -1200,6 +1499,15 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 			bootstrap_connections_max = std::stoul (bootstrap_connections_max_l);
 			lmdb_max_dbs = std::stoi (lmdb_max_dbs_l);
 			online_weight_quorum = std::stoul (online_weight_quorum_l);
+			signature_checker_threads = std::stoul (signature_checker_threads_l);
+			udp_sockets = std::stoul (udp_sockets_l);
+			block_processor_batch_max = std::stoul (block_processor_batch_max_l);
+			block_processor_live_latency = std::chrono::milliseconds (std::stoul (block_processor_live_latency_l));
+			block_processor_bootstrap_latency = std::chrono::milliseconds (std::stoul (block_processor_bootstrap_latency_l));
+			unchecked_cache_max = std::stoul (unchecked_cache_max_l);
+			unchecked_max = std::stoul (unchecked_max_l);
+			unchecked_cutoff = std::chrono::seconds (std::stoul (unchecked_cutoff_l));
+			vote_generator_delay = std::chrono::milliseconds (std::stoul (vote_generator_delay_l));
 			result |= peering_port > std::numeric_limits<uint16_t>::max ();
 			result |= logging.deserialize_json (upgraded_a, logging_l);
 			result |= receive_minimum.decode_dec (receive_minimum_l);
@@ -1208,6 +1516,10 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 			result |= password_fanout < 16;
 			result |= password_fanout > 1024 * 1024;
 			result |= io_threads == 0;
+			result |= udp_sockets == 0;
+			result |= block_processor_batch_max == 0;
+			result |= unchecked_max == 0;
+			result |= store_backend != "lmdb" && store_backend != "volatile";
 		}
 		catch (std::logic_error const &)
 		{
@@ -1229,6 +1541,123 @@ rai::account rai::node_config::random_representative ()
 	return result;
 }
 
+void rai::signature_check_set::add (rai::uint256_union const & message_a, rai::public_key const & pub_key_a, rai::signature const & signature_a)
+{
+	messages.push_back (message_a);
+	pub_keys.push_back (pub_key_a);
+	signatures.push_back (signature_a);
+	verifications.push_back (0);
+}
+
+size_t rai::signature_check_set::size () const
+{
+	return messages.size ();
+}
+
+rai::signature_checker::signature_checker (unsigned threads_a) :
+stopped (false)
+{
+	for (auto i (0u); i < threads_a; ++i)
+	{
+		threads.push_back (std::thread ([this]() { run (); }));
+	}
+}
+
+rai::signature_checker::~signature_checker ()
+{
+	stop ();
+}
+
+void rai::signature_checker::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
+}
+
+void rai::signature_checker::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	// Queued batches are drained before exiting so no caller is left waiting in verify
+	while (!stopped || !tasks.empty ())
+	{
+		if (!tasks.empty ())
+		{
+			auto task (std::move (tasks.front ()));
+			tasks.pop_front ();
+			lock.unlock ();
+			task ();
+			lock.lock ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void rai::signature_checker::verify_batch (rai::signature_check_set & check_a, size_t start_a, size_t size_a)
+{
+	std::vector<unsigned char const *> messages;
+	std::vector<size_t> lengths;
+	std::vector<unsigned char const *> pub_keys;
+	std::vector<unsigned char const *> signatures;
+	messages.reserve (size_a);
+	lengths.reserve (size_a);
+	pub_keys.reserve (size_a);
+	signatures.reserve (size_a);
+	for (auto i (start_a), n (start_a + size_a); i < n; ++i)
+	{
+		messages.push_back (check_a.messages[i].bytes.data ());
+		lengths.push_back (sizeof (check_a.messages[i].bytes));
+		pub_keys.push_back (check_a.pub_keys[i].bytes.data ());
+		signatures.push_back (check_a.signatures[i].bytes.data ());
+	}
+	rai::validate_message_batch (messages.data (), lengths.data (), pub_keys.data (), signatures.data (), size_a, check_a.verifications.data () + start_a);
+}
+
+void rai::signature_checker::verify (rai::signature_check_set & check_a)
+{
+	auto size (check_a.size ());
+	std::unique_lock<std::mutex> lock (mutex);
+	if (size <= batch_size || threads.empty () || stopped)
+	{
+		lock.unlock ();
+		verify_batch (check_a, 0, size);
+	}
+	else
+	{
+		// The calling thread verifies the first batch while the pool works through the rest
+		auto remaining (std::make_shared<std::atomic<size_t>> ((size - 1) / batch_size));
+		auto done (std::make_shared<std::promise<void>> ());
+		auto future (done->get_future ());
+		for (auto start (batch_size); start < size; start += batch_size)
+		{
+			auto count (std::min (batch_size, size - start));
+			tasks.push_back ([this, &check_a, start, count, remaining, done]() {
+				verify_batch (check_a, start, count);
+				if (--*remaining == 0)
+				{
+					done->set_value ();
+				}
+			});
+		}
+		condition.notify_all ();
+		lock.unlock ();
+		verify_batch (check_a, 0, batch_size);
+		future.wait ();
+	}
+}
+
 rai::vote_processor::vote_processor (rai::node & node_a) :
 node (node_a),
 started (false),
@@ -1256,11 +1685,12 @@ void rai::vote_processor::process_loop ()
 			votes_l.swap (votes);
 			active = true;
 			lock.unlock ();
+			verify_votes (votes_l);
 			{
 				rai::transaction transaction (node.store.environment, nullptr, false);
 				for (auto & i : votes_l)
 				{
-					vote_blocking (transaction, i.first, i.second);
+					vote_blocking (transaction, i.first, i.second, true);
 				}
 			}
 			lock.lock ();
@@ -1285,11 +1715,38 @@ void rai::vote_processor::vote (std::shared_ptr<rai::vote> vote_a, rai::endpoint
 	}
 }
 
-rai::vote_code rai::vote_processor::vote_blocking (MDB_txn * transaction_a, std::shared_ptr<rai::vote> vote_a, rai::endpoint endpoint_a)
+void rai::vote_processor::verify_votes (std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> & votes_a)
+{
+	rai::signature_check_set check;
+	for (auto & i : votes_a)
+	{
+		check.add (i.first->hash (), i.first->account, i.first->signature);
+	}
+	node.checker.verify (check);
+	std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> verified;
+	for (size_t i (0), n (votes_a.size ()); i < n; ++i)
+	{
+		if (check.verifications[i] == 1)
+		{
+			verified.push_back (votes_a[i]);
+		}
+		else
+		{
+			node.stats.inc (rai::stat::type::vote, rai::stat::detail::vote_invalid);
+			if (node.config.logging.vote_logging ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Vote from: %1% sequence: %2% block(s): %3%status: Invalid") % votes_a[i].first->account.to_account () % std::to_string (votes_a[i].first->sequence) % votes_a[i].first->hashes_string ());
+			}
+		}
+	}
+	votes_a.swap (verified);
+}
+
+rai::vote_code rai::vote_processor::vote_blocking (MDB_txn * transaction_a, std::shared_ptr<rai::vote> vote_a, rai::endpoint endpoint_a, bool validated)
 {
 	assert (endpoint_a.address ().is_v6 ());
 	auto result (rai::vote_code::invalid);
-	if (!vote_a->validate ())
+	if (validated || !vote_a->validate ())
 	{
 		result = rai::vote_code::replay;
 		auto max_vote (node.store.vote_max (transaction_a, vote_a));
@@ -1355,6 +1812,139 @@ void rai::vote_processor::stop ()
 	}
 }
 
+rai::vote_generator::vote_generator (rai::node & node_a, std::chrono::milliseconds wait_a) :
+node (node_a),
+wait (wait_a),
+stopped (false),
+started (false),
+thread ([this]() { run (); })
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!started)
+	{
+		condition.wait (lock);
+	}
+}
+
+void rai::vote_generator::add (rai::block_hash const & hash_a)
+{
+	push (hash_a, boost::none);
+}
+
+void rai::vote_generator::add (rai::block_hash const & hash_a, rai::endpoint const & endpoint_a)
+{
+	push (hash_a, endpoint_a);
+}
+
+void rai::vote_generator::push (rai::block_hash const & hash_a, boost::optional<rai::endpoint> const & endpoint_a)
+{
+	if (node.config.enable_voting)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		hashes.push_back (std::make_pair (hash_a, endpoint_a));
+		// Wake the generator to start the window on the first hash and to send once a vote is full
+		if (hashes.size () == 1 || hashes.size () >= rai::confirm_ack::hashes_max)
+		{
+			condition.notify_all ();
+		}
+	}
+}
+
+void rai::vote_generator::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+void rai::vote_generator::send (std::unique_lock<std::mutex> & lock_a)
+{
+	std::vector<rai::block_hash> hashes_l;
+	hashes_l.reserve (rai::confirm_ack::hashes_max);
+	std::unordered_set<rai::endpoint> peers_l;
+	auto local_l (false);
+	while (!hashes.empty () && hashes_l.size () < rai::confirm_ack::hashes_max)
+	{
+		auto & front (hashes.front ());
+		if (std::find (hashes_l.begin (), hashes_l.end (), front.first) == hashes_l.end ())
+		{
+			hashes_l.push_back (front.first);
+		}
+		if (front.second)
+		{
+			peers_l.insert (*front.second);
+		}
+		else
+		{
+			local_l = true;
+		}
+		hashes.pop_front ();
+	}
+	lock_a.unlock ();
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		node.wallets.foreach_representative (transaction, [this, &hashes_l, &peers_l, local_l, &transaction](rai::public_key const & pub_a, rai::raw_key const & prv_a) {
+			// One signature per representative covers local votes and every confirm_req reply in the window
+			auto vote (this->node.store.vote_generate (transaction, pub_a, prv_a, hashes_l));
+			if (local_l)
+			{
+				this->node.vote_processor.vote (vote, this->node.network.endpoint ());
+			}
+			if (!peers_l.empty ())
+			{
+				rai::confirm_ack confirm (vote);
+				std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
+				{
+					rai::vectorstream stream (*bytes);
+					confirm.serialize (stream);
+				}
+				for (auto & peer : peers_l)
+				{
+					this->node.network.confirm_send (confirm, bytes, peer);
+				}
+			}
+		});
+	}
+	lock_a.lock ();
+}
+
+void rai::vote_generator::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	started = true;
+	condition.notify_all ();
+	while (!stopped)
+	{
+		if (hashes.size () >= rai::confirm_ack::hashes_max)
+		{
+			send (lock);
+		}
+		else if (!hashes.empty ())
+		{
+			// Hashes queued while the previous vote was signed already share this one, waiting is opt in
+			auto cutoff (std::chrono::steady_clock::now () + wait);
+			while (!stopped && hashes.size () < rai::confirm_ack::hashes_max && std::chrono::steady_clock::now () < cutoff)
+			{
+				condition.wait_until (lock, cutoff);
+			}
+			if (!stopped)
+			{
+				send (lock);
+			}
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
 void rai::vote_processor::flush ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
@@ -1382,11 +1972,216 @@ bool rai::rep_crawler::exists (rai::block_hash const & hash_a)
 	return active.count (hash_a) != 0;
 }
 
+rai::block_queue_lane::block_queue_lane (size_t max_a) :
+count (0),
+max (max_a)
+{
+}
+
+std::shared_ptr<rai::block> rai::block_queue_lane::push (rai::block_processor_item const & item_a, size_t source_a, uint64_t difficulty_a)
+{
+	std::shared_ptr<rai::block> result;
+	if (count >= max)
+	{
+		// Make room by dropping the least difficult block of the source with the most blocks waiting
+		// Source 0 holds blocks released from the unchecked table, these were already accepted and are never dropped
+		auto largest (sources.end ());
+		for (auto i (sources.begin ()), n (sources.end ()); i != n; ++i)
+		{
+			if (i->first != 0 && (largest == sources.end () || i->second.size () > largest->second.size () || (i->second.size () == largest->second.size () && i->first == source_a)))
+			{
+				largest = i;
+			}
+		}
+		if (largest != sources.end ())
+		{
+			auto lowest (largest->second.begin ());
+			if (largest->first == source_a && lowest->first >= difficulty_a)
+			{
+				result = item_a.block;
+			}
+			else
+			{
+				result = lowest->second.block;
+				largest->second.erase (lowest);
+				--count;
+				if (largest->second.empty ())
+				{
+					turns.erase (std::find (turns.begin (), turns.end (), largest->first));
+					sources.erase (largest);
+				}
+			}
+		}
+		else if (source_a != 0)
+		{
+			result = item_a.block;
+		}
+	}
+	if (result != item_a.block)
+	{
+		auto & source (sources[source_a]);
+		if (source.empty ())
+		{
+			turns.push_back (source_a);
+		}
+		source.insert (std::make_pair (difficulty_a, item_a));
+		++count;
+	}
+	return result;
+}
+
+rai::block_processor_item rai::block_queue_lane::pop ()
+{
+	assert (!empty ());
+	auto source_l (turns.front ());
+	turns.pop_front ();
+	auto existing (sources.find (source_l));
+	assert (existing != sources.end ());
+	auto highest (std::prev (existing->second.end ()));
+	auto result (highest->second);
+	existing->second.erase (highest);
+	--count;
+	if (existing->second.empty ())
+	{
+		sources.erase (existing);
+	}
+	else
+	{
+		turns.push_back (source_l);
+	}
+	return result;
+}
+
+bool rai::block_queue_lane::empty () const
+{
+	return count == 0;
+}
+
+size_t rai::block_queue_lane::size () const
+{
+	return count;
+}
+
+rai::write_batch_controller::write_batch_controller (size_t min_a, size_t max_a) :
+per_block (0),
+commit (0),
+min (std::min (min_a, max_a)),
+max (max_a)
+{
+}
+
+size_t rai::write_batch_controller::batch_size (std::chrono::steady_clock::duration target_a) const
+{
+	auto result (max);
+	if (per_block.count () > 0)
+	{
+		auto available (target_a - commit);
+		result = available > per_block * static_cast<std::chrono::steady_clock::rep> (min) ? std::min<size_t> (max, available / per_block) : min;
+	}
+	return result;
+}
+
+void rai::write_batch_controller::record (size_t blocks_a, std::chrono::steady_clock::duration processing_a, std::chrono::steady_clock::duration commit_a)
+{
+	if (blocks_a > 0)
+	{
+		auto per_block_l (std::max (std::chrono::steady_clock::duration (1), processing_a / static_cast<std::chrono::steady_clock::rep> (blocks_a)));
+		if (per_block.count () == 0)
+		{
+			per_block = per_block_l;
+			commit = commit_a;
+		}
+		else
+		{
+			// New samples are weighted by a quarter so a single slow commit doesn't collapse the batch size
+			per_block = (per_block * 3 + per_block_l) / 4;
+			commit = (commit * 3 + commit_a) / 4;
+		}
+	}
+}
+
+rai::block_queue::block_queue () :
+local (std::numeric_limits<size_t>::max ()),
+live (live_max),
+bootstrap (bootstrap_max),
+live_streak (0)
+{
+}
+
+std::shared_ptr<rai::block> rai::block_queue::push (rai::block_processor_item const & item_a, size_t source_a)
+{
+	auto difficulty (rai::work_value (item_a.block->root (), item_a.block->block_work ()));
+	return lane (item_a.origin).push (item_a, source_a, difficulty);
+}
+
+rai::block_processor_item rai::block_queue::pop ()
+{
+	assert (!empty ());
+	rai::block_processor_item result;
+	if (!local.empty ())
+	{
+		result = local.pop ();
+	}
+	else if (!live.empty () && (bootstrap.empty () || live_streak < live_weight))
+	{
+		result = live.pop ();
+		++live_streak;
+	}
+	else
+	{
+		result = bootstrap.pop ();
+		live_streak = 0;
+	}
+	return result;
+}
+
+bool rai::block_queue::empty () const
+{
+	return local.empty () && live.empty () && bootstrap.empty ();
+}
+
+size_t rai::block_queue::size () const
+{
+	return local.size () + live.size () + bootstrap.size ();
+}
+
+size_t rai::block_queue::size (rai::block_origin origin_a) const
+{
+	return lane (origin_a).size ();
+}
+
+rai::block_queue_lane & rai::block_queue::lane (rai::block_origin origin_a)
+{
+	return const_cast<rai::block_queue_lane &> (static_cast<rai::block_queue const &> (*this).lane (origin_a));
+}
+
+rai::block_queue_lane const & rai::block_queue::lane (rai::block_origin origin_a) const
+{
+	rai::block_queue_lane const * result;
+	switch (origin_a)
+	{
+		case rai::block_origin::local:
+			result = &local;
+			break;
+		case rai::block_origin::live:
+			result = &live;
+			break;
+		case rai::block_origin::bootstrap:
+		default:
+			result = &bootstrap;
+			break;
+	}
+	return *result;
+}
+
 rai::block_processor::block_processor (rai::node & node_a) :
 stopped (false),
 active (false),
+verifying (false),
+checked_live (0),
 node (node_a),
-next_log (std::chrono::steady_clock::now ())
+next_log (std::chrono::steady_clock::now ()),
+batch (batch_min, node_a.config.block_processor_batch_max)
 {
 }
 
@@ -1405,7 +2200,7 @@ void rai::block_processor::stop ()
 void rai::block_processor::flush ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && (!blocks.empty () || active))
+	while (!stopped && (!blocks.empty () || !checked.empty () || active || verifying))
 	{
 		condition.wait (lock);
 	}
@@ -1414,19 +2209,30 @@ void rai::block_processor::flush ()
 bool rai::block_processor::full ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	return blocks.size () > 16384;
+	return (blocks.size (rai::block_origin::bootstrap) + checked.size ()) > bootstrap_full;
 }
 
-void rai::block_processor::add (std::shared_ptr<rai::block> block_a, std::chrono::steady_clock::time_point origination)
+void rai::block_processor::add (std::shared_ptr<rai::block> block_a, std::chrono::steady_clock::time_point origination, rai::block_origin origin_a, size_t source_a)
 {
 	if (!rai::work_validate (block_a->root (), block_a->block_work ()))
 	{
-		std::lock_guard<std::mutex> lock (mutex);
-		if (blocks_hashes.find (block_a->hash ()) == blocks_hashes.end ())
+		std::unique_lock<std::mutex> lock (mutex);
+		auto hash (block_a->hash ());
+		if (blocks_hashes.find (hash) == blocks_hashes.end ())
 		{
-			blocks.push_back (std::make_pair (block_a, origination));
-			blocks_hashes.insert (block_a->hash ());
-			condition.notify_all ();
+			auto dropped (blocks.push ({ block_a, origination, rai::signature_verification::unknown, origin_a }, source_a));
+			if (dropped != block_a)
+			{
+				blocks_hashes.insert (hash);
+				condition.notify_all ();
+			}
+			if (dropped != nullptr)
+			{
+				blocks_hashes.erase (dropped->hash ());
+				lock.unlock ();
+				node.stats.inc (rai::stat::type::block, rai::stat::detail::queue_overflow);
+				forget (dropped);
+			}
 		}
 	}
 	else
@@ -1436,6 +2242,13 @@ void rai::block_processor::add (std::shared_ptr<rai::block> block_a, std::chrono
 	}
 }
 
+void rai::block_processor::forget (std::shared_ptr<rai::block> block_a)
+{
+	// Otherwise later copies would be discarded as duplicates for as long as the arrival and filter entries live
+	node.block_arrival.remove (block_a->hash ());
+	node.network.publish_filter.clear (node.network.publish_filter.digest (block_a));
+}
+
 void rai::block_processor::force (std::shared_ptr<rai::block> block_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
@@ -1448,72 +2261,205 @@ void rai::block_processor::process_blocks ()
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!stopped)
 	{
-		if (have_blocks ())
+		if (!checked.empty () || !forced.empty ())
+		{
+			active = true;
+			lock.unlock ();
+			process_receive_many (lock);
+			lock.lock ();
+			active = false;
+			// Room was made in checked for the verification thread
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.notify_all ();
+			condition.wait (lock);
+		}
+	}
+}
+
+void rai::block_processor::verify_blocks ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!blocks.empty () && checked.size () < checked_max)
+		{
+			verifying = true;
+			verify_batch (lock);
+			verifying = false;
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+bool rai::block_processor::should_log ()
+{
+	auto result (false);
+	auto now (std::chrono::steady_clock::now ());
+	if (next_log < now)
+	{
+		next_log = now + std::chrono::seconds (15);
+		result = true;
+	}
+	return result;
+}
+
+void rai::block_processor::verify_batch (std::unique_lock<std::mutex> & lock_a)
+{
+	assert (!mutex.try_lock ());
+	std::deque<rai::block_processor_item> items;
+	while (!blocks.empty () && items.size () < verification_max)
+	{
+		items.push_back (blocks.pop ());
+	}
+	lock_a.unlock ();
+	// Open and state blocks name their signer, other blocks are signed by the account owning their previous block.
+	// An account never changes once a block is stored so it can be read here while the writer is busy with an earlier batch.
+	rai::signature_check_set check;
+	std::vector<bool> embedded;
+	embedded.reserve (items.size ());
+	// Accounts of blocks earlier in this batch, chains arriving together from bootstrap aren't stored yet
+	std::unordered_map<rai::block_hash, rai::account> accounts;
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		for (auto & item : items)
+		{
+			auto & block (*item.block);
+			rai::account account (0);
+			switch (block.type ())
+			{
+				case rai::block_type::open:
+					account = static_cast<rai::open_block const &> (block).hashables.account;
+					break;
+				case rai::block_type::state:
+					account = static_cast<rai::state_block const &> (block).hashables.account;
+					break;
+				default:
+				{
+					auto existing (accounts.find (block.previous ()));
+					if (existing != accounts.end ())
+					{
+						account = existing->second;
+					}
+					else
+					{
+						// Previous block not stored yet or stored without sideband, the ledger checks it when writing
+						rai::block_sideband sideband;
+						if (!node.store.block_sideband_get (transaction, block.previous (), sideband))
+						{
+							account = sideband.account;
+						}
+					}
+					break;
+				}
+			}
+			embedded.push_back (!account.is_zero ());
+			if (!account.is_zero ())
+			{
+				auto hash (block.hash ());
+				// A hash fixes the block's contents so its account holds even if this copy's signature fails
+				accounts[hash] = account;
+				check.add (hash, account, block.block_signature ());
+			}
+		}
+	}
+	node.checker.verify (check);
+	lock_a.lock ();
+	size_t index (0);
+	for (size_t i (0), n (items.size ()); i < n; ++i)
+	{
+		auto & item (items[i]);
+		auto verification (rai::signature_verification::unknown);
+		auto drop (false);
+		if (embedded[i])
 		{
-			active = true;
-			lock.unlock ();
-			process_receive_many (lock);
-			lock.lock ();
-			active = false;
+			if (check.verifications[index] == 1)
+			{
+				verification = rai::signature_verification::valid;
+			}
+			else
+			{
+				// Epoch blocks are signed by the epoch signer and are left for the ledger to check
+				auto & ledger (node.ledger);
+				drop = item.block->type () != rai::block_type::state || ledger.epoch_link.is_zero () || static_cast<rai::state_block const &> (*item.block).hashables.link != ledger.epoch_link;
+			}
+			++index;
 		}
-		else
+		if (drop)
 		{
-			condition.notify_all ();
-			condition.wait (lock);
+			auto hash (item.block->hash ());
+			blocks_hashes.erase (hash);
+			if (node.config.logging.ledger_logging ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Bad signature for: %1%") % hash.to_string ());
+			}
+			continue;
 		}
+		item.verification = verification;
+		if (item.origin != rai::block_origin::bootstrap)
+		{
+			++checked_live;
+		}
+		checked.push_back (item);
 	}
 }
 
-bool rai::block_processor::should_log ()
-{
-	auto result (false);
-	auto now (std::chrono::steady_clock::now ());
-	if (next_log < now)
-	{
-		next_log = now + std::chrono::seconds (15);
-		result = true;
-	}
-	return result;
-}
-
-bool rai::block_processor::have_blocks ()
+bool rai::block_processor::live_waiting ()
 {
 	assert (!mutex.try_lock ());
-	return !blocks.empty () || !forced.empty ();
+	auto result (!forced.empty () || checked_live > 0 || blocks.size (rai::block_origin::local) + blocks.size (rai::block_origin::live) > 0);
+	return result;
 }
 
 void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> & lock_a)
 {
+	size_t count (0);
+	auto start (std::chrono::steady_clock::now ());
+	std::chrono::steady_clock::time_point processed;
 	{
 		rai::transaction transaction (node.store.environment, nullptr, true);
-		auto cutoff (std::chrono::steady_clock::now () + rai::transaction_timeout);
 		lock_a.lock ();
-		auto count (0);
-		while (have_blocks () && count < 16384)
-		{
-			if (blocks.size () > 64 && should_log ())
+		auto live (live_waiting ());
+		auto target (live ? node.config.block_processor_live_latency : node.config.block_processor_bootstrap_latency);
+		auto size (batch.batch_size (target));
+		// Stop early if blocks turn out slower than estimated, leaving time for the commit
+		auto cutoff (start + target - batch.commit);
+		while ((!checked.empty () || !forced.empty ()) && count < size && (count == 0 || std::chrono::steady_clock::now () < cutoff))
+		{
+			if (blocks.size () + checked.size () > 64 && should_log ())
 			{
-				BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks in processing queue") % blocks.size ());
+				BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks in processing queue") % (blocks.size () + checked.size ()));
 			}
-			std::pair<std::shared_ptr<rai::block>, std::chrono::steady_clock::time_point> block;
+			rai::block_processor_item block;
 			bool force (false);
 			if (forced.empty ())
 			{
-				block = blocks.front ();
-				blocks.pop_front ();
-				blocks_hashes.erase (block.first->hash ());
+				block = checked.front ();
+				checked.pop_front ();
+				if (block.origin != rai::block_origin::bootstrap)
+				{
+					assert (checked_live > 0);
+					--checked_live;
+				}
+				blocks_hashes.erase (block.block->hash ());
 			}
 			else
 			{
-				block = std::make_pair (forced.front (), std::chrono::steady_clock::now ());
+				block = { forced.front (), std::chrono::steady_clock::now (), rai::signature_verification::unknown, rai::block_origin::local };
 				forced.pop_front ();
 				force = true;
 			}
 			lock_a.unlock ();
-			auto hash (block.first->hash ());
+			auto hash (block.block->hash ());
 			if (force)
 			{
-				auto successor (node.ledger.successor (transaction, block.first->root ()));
+				auto successor (node.ledger.successor (transaction, block.block->root ()));
 				if (successor != nullptr && successor->hash () != hash)
 				{
 					// Replace our block with the winner and roll back any dependent blocks
@@ -1521,20 +2467,30 @@ void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> &
 					node.ledger.rollback (transaction, successor->hash ());
 				}
 			}
-			auto process_result (process_receive_one (transaction, block.first, block.second));
+			auto process_result (process_receive_one (transaction, block.block, block.origination, block.verification, block.origin));
 			(void)process_result;
 			lock_a.lock ();
 			++count;
+			if (!live && live_waiting ())
+			{
+				// A live block arrived during a bootstrap batch, commit by the live deadline so it isn't stuck behind the rest
+				live = true;
+				target = node.config.block_processor_live_latency;
+				size = std::min (size, batch.batch_size (target));
+				cutoff = std::min (cutoff, start + target - batch.commit);
+			}
 		}
+		lock_a.unlock ();
+		processed = std::chrono::steady_clock::now ();
 	}
-	lock_a.unlock ();
+	batch.record (count, processed - start, std::chrono::steady_clock::now () - processed);
 }
 
-rai::process_return rai::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr<rai::block> block_a, std::chrono::steady_clock::time_point origination)
+rai::process_return rai::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr<rai::block> block_a, std::chrono::steady_clock::time_point origination, rai::signature_verification verification_a, rai::block_origin origin_a)
 {
 	rai::process_return result;
 	auto hash (block_a->hash ());
-	result = node.ledger.process (transaction_a, *block_a);
+	result = node.ledger.process (transaction_a, *block_a, verification_a);
 	switch (result.code)
 	{
 		case rai::process_result::progress:
@@ -1549,7 +2505,7 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 			{
 				node.active.start (block_a);
 			}
-			queue_unchecked (transaction_a, hash);
+			queue_unchecked (transaction_a, hash, origin_a);
 			break;
 		}
 		case rai::process_result::gap_previous:
@@ -1558,7 +2514,11 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 			{
 				BOOST_LOG (node.log) << boost::str (boost::format ("Gap previous for: %1%") % hash.to_string ());
 			}
-			node.store.unchecked_put (transaction_a, block_a->previous (), block_a);
+			if (node.store.unchecked_put (transaction_a, block_a->previous (), block_a))
+			{
+				node.stats.inc (rai::stat::type::block, rai::stat::detail::unchecked_overflow);
+				forget (block_a);
+			}
 			node.gap_cache.add (transaction_a, block_a);
 			break;
 		}
@@ -1568,7 +2528,11 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 			{
 				BOOST_LOG (node.log) << boost::str (boost::format ("Gap source for: %1%") % hash.to_string ());
 			}
-			node.store.unchecked_put (transaction_a, node.ledger.block_source (transaction_a, *block_a), block_a);
+			if (node.store.unchecked_put (transaction_a, node.ledger.block_source (transaction_a, *block_a), block_a))
+			{
+				node.stats.inc (rai::stat::type::block, rai::stat::detail::unchecked_overflow);
+				forget (block_a);
+			}
 			node.gap_cache.add (transaction_a, block_a);
 			break;
 		}
@@ -1578,7 +2542,7 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 			{
 				BOOST_LOG (node.log) << boost::str (boost::format ("Old for: %1%") % block_a->hash ().to_string ());
 			}
-			queue_unchecked (transaction_a, hash);
+			queue_unchecked (transaction_a, hash, origin_a);
 			break;
 		}
 		case rai::process_result::bad_signature:
@@ -1651,13 +2615,14 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 	return result;
 }
 
-void rai::block_processor::queue_unchecked (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+void rai::block_processor::queue_unchecked (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_origin origin_a)
 {
+	// Dependents are queued in the lane of the block that resolved them, as a source of their own
 	auto cached (node.store.unchecked_get (transaction_a, hash_a));
 	for (auto i (cached.begin ()), n (cached.end ()); i != n; ++i)
 	{
 		node.store.unchecked_del (transaction_a, hash_a, **i);
-		add (*i, std::chrono::steady_clock::time_point ());
+		add (*i, std::chrono::steady_clock::time_point (), origin_a);
 	}
 	std::lock_guard<std::mutex> lock (node.gap_cache.mutex);
 	node.gap_cache.blocks.get<1> ().erase (hash_a);
@@ -1673,7 +2638,7 @@ service (service_a),
 config (config_a),
 alarm (alarm_a),
 work (work_a),
-store (init_a.block_store_init, application_path_a / "data.ldb", config_a.lmdb_max_dbs),
+store (init_a.block_store_init, config_a.store_backend == "volatile" ? boost::filesystem::temp_directory_path () / boost::filesystem::unique_path ("%%%%-%%%%-%%%%-%%%%.ldb") : application_path_a / "data.ldb", config_a.lmdb_max_dbs, config_a.store_backend != "volatile"),
 gap_cache (*this),
 ledger (store, stats, config.epoch_block_link, config.epoch_block_signer),
 active (*this),
@@ -1684,13 +2649,18 @@ peers (network.endpoint ()),
 application_path (application_path_a),
 wallets (init_a.block_store_init, *this),
 port_mapping (*this),
+checker (config.signature_checker_threads),
 vote_processor (*this),
+vote_generator (*this, config.vote_generator_delay),
 warmed_up (0),
 block_processor (*this),
 block_processor_thread ([this]() { this->block_processor.process_blocks (); }),
+block_verification_thread ([this]() { this->block_processor.verify_blocks (); }),
 online_reps (*this),
 stats (config.stat_config)
 {
+	store.unchecked_cache_max = config.unchecked_cache_max;
+	store.unchecked_max = config.unchecked_max;
 	wallets.observer = [this](bool active) {
 		observers.wallet.notify (active);
 	};
@@ -1851,6 +2821,10 @@ stats (config.stat_config)
 	});
 	BOOST_LOG (log) << "Node starting, version: " << RAIBLOCKS_VERSION_MAJOR << "." << RAIBLOCKS_VERSION_MINOR;
 	BOOST_LOG (log) << boost::str (boost::format ("Work pool running %1% threads") % work.threads.size ());
+	if (!store.environment.durable)
+	{
+		BOOST_LOG (log) << boost::str (boost::format ("Using volatile store at %1%, the ledger is discarded on shutdown and wallets can't be created") % store.environment.path.string ());
+	}
 	if (!init_a.error ())
 	{
 		if (config.logging.node_lifetime_tracing ())
@@ -2069,11 +3043,11 @@ void rai::network::confirm_send (rai::confirm_ack const & confirm_a, std::shared
 	});
 }
 
-void rai::node::process_active (std::shared_ptr<rai::block> incoming)
+void rai::node::process_active (std::shared_ptr<rai::block> incoming, rai::block_origin origin_a, size_t source_a)
 {
 	if (!block_arrival.add (incoming->hash ()))
 	{
-		block_processor.add (incoming, std::chrono::steady_clock::now ());
+		block_processor.add (incoming, std::chrono::steady_clock::now (), origin_a, source_a);
 	}
 }
 
@@ -2289,6 +3263,7 @@ void rai::node::start ()
 	ongoing_syn_cookie_cleanup ();
 	ongoing_bootstrap ();
 	ongoing_store_flush ();
+	ongoing_unchecked_cleanup ();
 	ongoing_rep_crawl ();
 	bootstrap.start ();
 	backup_wallet ();
@@ -2306,12 +3281,18 @@ void rai::node::stop ()
 	{
 		block_processor_thread.join ();
 	}
+	if (block_verification_thread.joinable ())
+	{
+		block_verification_thread.join ();
+	}
 	active.stop ();
 	network.stop ();
 	bootstrap_initiator.stop ();
 	bootstrap.stop ();
 	port_mapping.stop ();
+	vote_generator.stop ();
 	vote_processor.stop ();
+	checker.stop ();
 	wallets.stop ();
 }
 
@@ -2451,6 +3432,77 @@ void rai::node::ongoing_store_flush ()
 	});
 }
 
+void rai::node::ongoing_unchecked_cleanup ()
+{
+	// Bootstrap fills the table fastest, so it's trimmed while bootstrapping too
+	auto removed (unchecked_cleanup ());
+	if (removed > 0 && config.logging.ledger_logging ())
+	{
+		BOOST_LOG (log) << boost::str (boost::format ("Removed %1% old unchecked blocks") % removed);
+	}
+	std::weak_ptr<rai::node> node_w (shared_from_this ());
+	alarm.add (std::chrono::steady_clock::now () + std::chrono::hours (1), [node_w]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->ongoing_unchecked_cleanup ();
+		}
+	});
+}
+
+size_t rai::node::unchecked_cleanup ()
+{
+	size_t result (0);
+	auto cutoff (rai::seconds_since_epoch () - config.unchecked_cutoff.count ());
+	auto more (true);
+	while (more)
+	{
+		more = false;
+		// Oldest expired entries of this pass, capped so a large table isn't copied into memory
+		std::multimap<uint64_t, rai::unchecked_key> oldest;
+		rai::unchecked_key start;
+		auto resume (false);
+		auto done (false);
+		while (!done)
+		{
+			// Short read transactions so the scan doesn't pin old pages while the block processor writes
+			rai::transaction transaction (store.environment, nullptr, false);
+			auto i (store.unchecked_begin (transaction, start));
+			auto n (store.unchecked_end ());
+			if (resume && i != n && rai::unchecked_key (i->first) == start)
+			{
+				++i;
+			}
+			for (size_t count (0); i != n && count < unchecked_cleanup_batch; ++i, ++count)
+			{
+				rai::unchecked_info info (i->second);
+				if (info.modified < cutoff)
+				{
+					oldest.insert (std::make_pair (info.modified, rai::unchecked_key (i->first)));
+					if (oldest.size () > unchecked_cleanup_max)
+					{
+						oldest.erase (std::prev (oldest.end ()));
+						more = true;
+					}
+				}
+				start = rai::unchecked_key (i->first);
+			}
+			resume = true;
+			done = i == n;
+		}
+		auto j (oldest.begin ());
+		while (j != oldest.end ())
+		{
+			rai::transaction transaction (store.environment, nullptr, true);
+			for (size_t count (0); j != oldest.end () && count < unchecked_cleanup_batch; ++j, ++count)
+			{
+				store.unchecked_del (transaction, j->second);
+				++result;
+			}
+		}
+	}
+	return result;
+}
+
 void rai::node::backup_wallet ()
 {
 	rai::transaction transaction (store.environment, nullptr, false);
@@ -2936,6 +3988,12 @@ bool rai::block_arrival::recent (rai::block_hash const & hash_a)
 	return arrival.get<1> ().find (hash_a) != arrival.get<1> ().end ();
 }
 
+void rai::block_arrival::remove (rai::block_hash const & hash_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	arrival.get<1> ().erase (hash_a);
+}
+
 rai::online_reps::online_reps (rai::node & node) :
 node (node)
 {
@@ -3496,6 +4554,18 @@ void rai::network::send_buffer (uint8_t const * data_a, size_t size_a, rai::endp
 	{
 		BOOST_LOG (node.log) << "Sending packet";
 	}
+	if (batch_io)
+	{
+		send_queue.push_back (rai::udp_send{ data_a, size_a, endpoint_a, callback_a });
+		if (!sending)
+		{
+			sending = true;
+			socket.async_wait (boost::asio::ip::udp::socket::wait_write, [this](boost::system::error_code const & ec) {
+				send_batch_action (ec);
+			});
+		}
+		return;
+	}
 	socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a](boost::system::error_code const & ec, size_t size_a) {
 		callback_a (ec, size_a);
 		this->node.stats.add (rai::stat::type::traffic, rai::stat::dir::out, size_a);
@@ -3506,6 +4576,62 @@ void rai::network::send_buffer (uint8_t const * data_a, size_t size_a, rai::endp
 	});
 }
 
+void rai::network::send_batch_action (boost::system::error_code const & error)
+{
+	std::vector<rai::udp_send> batch;
+	{
+		std::lock_guard<std::mutex> lock (socket_mutex);
+		auto count (error ? send_queue.size () : std::min (send_queue.size (), udp_batch_size));
+		batch.assign (std::make_move_iterator (send_queue.begin ()), std::make_move_iterator (send_queue.begin () + count));
+		send_queue.erase (send_queue.begin (), send_queue.begin () + count);
+	}
+	size_t done (0);
+	if (!error)
+	{
+		boost::system::error_code ec;
+		auto sent (rai::udp_send_batch (socket, batch, ec));
+		for (; done < sent; ++done)
+		{
+			batch[done].callback (boost::system::error_code (), batch[done].size);
+			node.stats.add (rai::stat::type::traffic, rai::stat::dir::out, batch[done].size);
+		}
+		if (ec && ec != boost::asio::error::would_block && done < batch.size ())
+		{
+			// Only the datagram that hit the error fails, the rest get another attempt
+			batch[done].callback (ec, 0);
+			++done;
+		}
+	}
+	else
+	{
+		for (; done < batch.size (); ++done)
+		{
+			batch[done].callback (error, 0);
+		}
+	}
+	std::deque<rai::udp_send> aborted;
+	{
+		std::lock_guard<std::mutex> lock (socket_mutex);
+		send_queue.insert (send_queue.begin (), std::make_move_iterator (batch.begin () + done), std::make_move_iterator (batch.end ()));
+		if (on && !send_queue.empty ())
+		{
+			socket.async_wait (boost::asio::ip::udp::socket::wait_write, [this](boost::system::error_code const & ec) {
+				send_batch_action (ec);
+			});
+		}
+		else
+		{
+			sending = false;
+			// Nothing drains the queue once the network is stopped, every sender still gets its callback
+			aborted.swap (send_queue);
+		}
+	}
+	for (auto & i : aborted)
+	{
+		i.callback (boost::asio::error::operation_aborted, 0);
+	}
+}
+
 bool rai::peer_container::known_peer (rai::endpoint const & endpoint_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
@@ -3538,18 +4664,26 @@ status ({ block_a, 0 }),
 confirmed (false),
 aborted (false)
 {
-	last_votes.insert (std::make_pair (rai::not_an_account, rai::vote_info{ std::chrono::steady_clock::now (), 0, block_a->hash () }));
+	last_votes.insert (std::make_pair (rai::not_an_account, rai::vote_info{ std::chrono::steady_clock::now (), 0, block_a->hash (), 0 }));
 	blocks.insert (std::make_pair (block_a->hash (), block_a));
+	last_tally.insert (std::make_pair (block_a->hash (), 0));
 }
 
 void rai::election::compute_rep_votes (MDB_txn * transaction_a)
 {
 	if (node.config.enable_voting)
 	{
-		node.wallets.foreach_representative (transaction_a, [this, transaction_a](rai::public_key const & pub_a, rai::raw_key const & prv_a) {
-			auto vote (this->node.store.vote_generate (transaction_a, pub_a, prv_a, status.winner));
-			this->node.vote_processor.vote (vote, this->node.network.endpoint ());
-		});
+		if (std::chrono::system_clock::now () >= node.config.generate_hash_votes_at)
+		{
+			node.vote_generator.add (status.winner->hash ());
+		}
+		else
+		{
+			node.wallets.foreach_representative (transaction_a, [this, transaction_a](rai::public_key const & pub_a, rai::raw_key const & prv_a) {
+				auto vote (this->node.store.vote_generate (transaction_a, pub_a, prv_a, status.winner));
+				this->node.vote_processor.vote (vote, this->node.network.endpoint ());
+			});
+		}
 	}
 }
 
@@ -3585,14 +4719,8 @@ bool rai::election::have_quorum (rai::tally_t const & tally_a)
 
 rai::tally_t rai::election::tally (MDB_txn * transaction_a)
 {
-	std::unordered_map<rai::block_hash, rai::uint128_t> block_weights;
-	for (auto vote_info : last_votes)
-	{
-		block_weights[vote_info.second.hash] += node.ledger.weight (transaction_a, vote_info.first);
-	}
-	last_tally = block_weights;
 	rai::tally_t result;
-	for (auto item : block_weights)
+	for (auto item : last_tally)
 	{
 		auto block (blocks.find (item.first));
 		if (block != blocks.end ())
@@ -3690,7 +4818,12 @@ rai::election_vote_result rai::election::vote (rai::account rep, uint64_t sequen
 		}
 		if (should_process)
 		{
-			last_votes[rep] = { std::chrono::steady_clock::now (), sequence, block_hash };
+			if (last_vote_it != last_votes.end ())
+			{
+				last_tally[last_vote_it->second.hash] -= last_vote_it->second.weight;
+			}
+			last_votes[rep] = { std::chrono::steady_clock::now (), sequence, block_hash, weight };
+			last_tally[block_hash] += weight;
 			if (!confirmed)
 			{
 				confirm_if_quorum (transaction);
@@ -3717,32 +4850,78 @@ bool rai::election::publish (std::shared_ptr<rai::block> block_a)
 	return result;
 }
 
-void rai::active_transactions::announce_votes ()
+size_t rai::active_transactions::announce_votes ()
 {
-	std::unordered_set<rai::block_hash> inactive;
 	rai::transaction transaction (node.store.environment, nullptr, false);
+	auto now (std::chrono::steady_clock::now ());
 	unsigned unconfirmed_count (0);
 	unsigned unconfirmed_announcements (0);
 	unsigned mass_request_count (0);
-	std::vector<rai::block_hash> blocks_bundle;
+	std::vector<std::pair<double, rai::block_hash>> candidates;
+	// Blocks to request confirmation of, by peer, so each peer gets them in as few messages as its version allows
+	auto requests (std::make_shared<std::unordered_map<rai::endpoint, std::vector<std::pair<std::shared_ptr<rai::block>, bool>>>> ());
 
-	for (auto i (roots.begin ()), n (roots.end ()); i != n; ++i)
+	for (auto & shard_l : shards)
 	{
-		auto election_l (i->election);
-		if ((election_l->confirmed || election_l->aborted) && i->announcements >= announcement_min - 1)
+		std::vector<std::shared_ptr<rai::election>> inactive;
 		{
-			if (election_l->confirmed)
+			std::lock_guard<std::mutex> lock (shard_l.mutex);
+			for (auto i (shard_l.roots.begin ()), n (shard_l.roots.end ()); i != n; ++i)
 			{
-				confirmed.push_back (i->election->status);
-				if (confirmed.size () > election_history_size)
+				auto election_l (i->election);
+				// Rounds can be shorter than announce_interval_ms so the time an election has been running is checked as well
+				if ((election_l->confirmed || election_l->aborted) && i->announcements >= announcement_min - 1 && now - i->started >= std::chrono::milliseconds (announce_interval_ms) * (announcement_min - 1))
 				{
-					confirmed.pop_front ();
+					if (election_l->confirmed)
+					{
+						std::lock_guard<std::mutex> confirmed_lock (mutex);
+						confirmed.push_back (i->election->status);
+						if (confirmed.size () > election_history_size)
+						{
+							confirmed.pop_front ();
+						}
+					}
+					inactive.push_back (election_l);
+				}
+				else
+				{
+					candidates.push_back (std::make_pair (priority (transaction, *i, now), i->root));
+				}
+			}
+			for (auto election_l : inactive)
+			{
+				shard_l.roots.erase (election_l->root);
+			}
+		}
+		for (auto election_l : inactive)
+		{
+			for (auto successor : election_l->blocks)
+			{
+				auto & successor_shard (shard (successor.first));
+				std::lock_guard<std::mutex> lock (successor_shard.mutex);
+				auto successor_it (successor_shard.successors.find (successor.first));
+				if (successor_it != successor_shard.successors.end () && successor_it->second == election_l)
+				{
+					successor_shard.successors.erase (successor_it);
 				}
 			}
-			inactive.insert (election_l->root);
 		}
-		else
+	}
+	auto result (candidates.size ());
+	// Only the highest priority elections are announced this round, the waiting term raises the others until they get their turn
+	auto announce_count (std::min<size_t> (candidates.size (), announcements_per_interval));
+	std::partial_sort (candidates.begin (), candidates.begin () + announce_count, candidates.end (), [](std::pair<double, rai::block_hash> const & lhs, std::pair<double, rai::block_hash> const & rhs) {
+		return lhs.first > rhs.first;
+	});
+	candidates.resize (announce_count);
+	for (auto & candidate : candidates)
+	{
+		auto & shard_l (shard (candidate.second));
+		std::lock_guard<std::mutex> lock (shard_l.mutex);
+		auto i (shard_l.roots.find (candidate.second));
+		if (i != shard_l.roots.end ())
 		{
+			auto election_l (i->election);
 			if (i->announcements > announcement_long)
 			{
 				++unconfirmed_count;
@@ -3759,36 +4938,21 @@ void rai::active_transactions::announce_votes ()
 				// Broadcast winner
 				if (node.ledger.could_fit (transaction, *election_l->status.winner))
 				{
-					if (std::chrono::system_clock::now () >= node.config.generate_hash_votes_at)
-					{
-						node.network.republish_block (transaction, election_l->status.winner, false);
-						blocks_bundle.push_back (election_l->status.winner->hash ());
-						if (blocks_bundle.size () >= 12)
-						{
-							node.wallets.foreach_representative (transaction, [&](rai::public_key const & pub_a, rai::raw_key const & prv_a) {
-								auto vote (this->node.store.vote_generate (transaction, pub_a, prv_a, blocks_bundle));
-								this->node.vote_processor.vote (vote, this->node.network.endpoint ());
-							});
-							blocks_bundle.clear ();
-						}
-					}
-					else
-					{
-						election_l->compute_rep_votes (transaction);
-						node.network.republish_block (transaction, election_l->status.winner);
-					}
+					election_l->compute_rep_votes (transaction);
+					// Full block votes ride along with the publish until hash votes are generated
+					node.network.republish_block (transaction, election_l->status.winner, std::chrono::system_clock::now () < node.config.generate_hash_votes_at);
 				}
-				else if (i->announcements > 3)
+				else if (now - i->started > std::chrono::milliseconds (announce_interval_ms) * could_fit_intervals)
 				{
 					election_l->abort ();
 				}
 			}
 			if (i->announcements % 4 == 1)
 			{
-				auto reps (std::make_shared<std::vector<rai::peer_information>> (node.peers.representatives (std::numeric_limits<size_t>::max ())));
+				auto reps (node.peers.representatives (std::numeric_limits<size_t>::max ()));
 				std::unordered_set<rai::account> probable_reps;
 				rai::uint128_t total_weight (0);
-				for (auto j (reps->begin ()), m (reps->end ()); j != m;)
+				for (auto j (reps.begin ()), m (reps.end ()); j != m;)
 				{
 					auto & rep_votes (i->election->last_votes);
 					auto rep_acct (j->probable_rep_account);
@@ -3800,9 +4964,9 @@ void rai::active_transactions::announce_votes ()
 					}
 					if (rep_votes.find (rep_acct) != rep_votes.end ())
 					{
-						std::swap (*j, reps->back ());
-						reps->pop_back ();
-						m = reps->end ();
+						std::swap (*j, reps.back ());
+						reps.pop_back ();
+						m = reps.end ();
 					}
 					else
 					{
@@ -3813,53 +4977,71 @@ void rai::active_transactions::announce_votes ()
 						}
 					}
 				}
-				if (!reps->empty () && (total_weight > node.config.online_weight_minimum.number () || mass_request_count > 20))
+				if (!reps.empty () && (total_weight > node.config.online_weight_minimum.number () || mass_request_count > 20))
 				{
-					// broadcast_confirm_req_base modifies reps, so we clone it once to avoid aliasing
-					node.network.broadcast_confirm_req_base (i->confirm_req_options.first, std::make_shared<std::vector<rai::peer_information>> (*reps), 0);
+					for (auto & rep : reps)
+					{
+						(*requests)[rep.endpoint].push_back (std::make_pair (i->confirm_req_options.first, election_l->confirm_req_sent.insert (rep.endpoint).second));
+					}
 				}
 				else
 				{
 					// broadcast request to all peers
-					node.network.broadcast_confirm_req_base (i->confirm_req_options.first, std::make_shared<std::vector<rai::peer_information>> (node.peers.list_vector ()), 0);
+					for (auto & peer : node.peers.list_vector ())
+					{
+						(*requests)[peer.endpoint].push_back (std::make_pair (i->confirm_req_options.first, election_l->confirm_req_sent.insert (peer.endpoint).second));
+					}
 					++mass_request_count;
 				}
 			}
+			shard_l.roots.modify (i, [now](rai::conflict_info & info_a) {
+				++info_a.announcements;
+				info_a.announced = now;
+			});
 		}
-		roots.modify (i, [](rai::conflict_info & info_a) {
-			++info_a.announcements;
-		});
-	}
-	if (blocks_bundle.size () > 0)
-	{
-		node.wallets.foreach_representative (transaction, [&](rai::public_key const & pub_a, rai::raw_key const & prv_a) {
-			auto vote (this->node.store.vote_generate (transaction, pub_a, prv_a, blocks_bundle));
-			this->node.vote_processor.vote (vote, this->node.network.endpoint ());
-		});
 	}
-	for (auto i (inactive.begin ()), n (inactive.end ()); i != n; ++i)
+	if (!requests->empty ())
 	{
-		auto root_it (roots.find (*i));
-		assert (root_it != roots.end ());
-		for (auto successor : root_it->election->blocks)
-		{
-			auto successor_it (successors.find (successor.first));
-			if (successor_it != successors.end ())
-			{
-				assert (successor_it->second == root_it->election);
-				successors.erase (successor_it);
-			}
-			else
-			{
-				assert (false && "election successor not in active_transactions blocks table");
-			}
-		}
-		roots.erase (root_it);
+		node.network.broadcast_confirm_req_batch (requests, 0);
 	}
 	if (unconfirmed_count > 0)
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks have been unconfirmed averaging %2% announcements") % unconfirmed_count % (unconfirmed_announcements / unconfirmed_count));
 	}
+	return result;
+}
+
+double rai::active_transactions::priority (MDB_txn * transaction_a, rai::conflict_info const & info_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	auto winner (info_a.election->status.winner);
+	// Each doubling of work above the publish threshold counts as one interval waited
+	auto difficulty (rai::work_value (winner->root (), winner->block_work ()));
+	auto result (std::max (0.0, std::log2 (static_cast<double> (0 - rai::work_pool::publish_threshold) / std::max (1.0, static_cast<double> (0 - difficulty)))));
+	// Blocks from our own wallets go ahead of equivalent network traffic
+	rai::block_sideband sideband;
+	if (!node.store.block_sideband_get (transaction_a, winner->hash (), sideband) && node.wallets.exists (transaction_a, sideband.account))
+	{
+		result += 2.0;
+	}
+	// Elections close to quorum are worth finishing
+	auto online (node.online_reps.online_stake ());
+	if (!online.is_zero ())
+	{
+		result += 4.0 * std::min (1.0, info_a.election->status.tally.number ().convert_to<double> () / online.convert_to<double> ());
+	}
+	result += std::chrono::duration<double, std::milli> (now_a - info_a.announced).count () / announce_interval_ms;
+	return result;
+}
+
+std::chrono::milliseconds rai::active_transactions::announce_interval (size_t pending_a)
+{
+	auto result (announce_interval_ms);
+	if (pending_a != announcements_per_interval)
+	{
+		// Fewer elections are announced more often, a backlog beyond one round's budget is worked through at the shortest interval
+		result = pending_a < announcements_per_interval ? std::max<unsigned> (announce_interval_min_ms, announce_interval_ms * pending_a / announcements_per_interval) : announce_interval_min_ms;
+	}
+	return std::chrono::milliseconds (result);
 }
 
 void rai::active_transactions::announce_loop ()
@@ -3869,8 +5051,13 @@ void rai::active_transactions::announce_loop ()
 	condition.notify_all ();
 	while (!stopped)
 	{
-		announce_votes ();
-		condition.wait_for (lock, std::chrono::milliseconds (announce_interval_ms));
+		lock.unlock ();
+		auto pending (announce_votes ());
+		lock.lock ();
+		if (!stopped)
+		{
+			condition.wait_for (lock, announce_interval (pending));
+		}
 	}
 }
 
@@ -3883,15 +5070,31 @@ void rai::active_transactions::stop ()
 			condition.wait (lock);
 		}
 		stopped = true;
-		roots.clear ();
 		condition.notify_all ();
 	}
+	for (auto & shard_l : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard_l.mutex);
+		shard_l.roots.clear ();
+	}
 	if (thread.joinable ())
 	{
 		thread.join ();
 	}
 }
 
+rai::active_transactions_shard & rai::active_transactions::shard (rai::block_hash const & hash_a)
+{
+	return shards[hash_a.qwords[0] % shard_count];
+}
+
+void rai::active_transactions::successor_add (rai::block_hash const & hash_a, std::shared_ptr<rai::election> election_a)
+{
+	auto & shard_l (shard (hash_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	shard_l.successors.insert (std::make_pair (hash_a, election_a));
+}
+
 bool rai::active_transactions::start (std::shared_ptr<rai::block> block_a, std::function<void(std::shared_ptr<rai::block>)> const & confirmation_action_a)
 {
 	return start (std::make_pair (block_a, nullptr), confirmation_action_a);
@@ -3901,19 +5104,27 @@ bool rai::active_transactions::start (std::pair<std::shared_ptr<rai::block>, std
 {
 	assert (blocks_a.first != nullptr);
 	auto error (true);
-	std::lock_guard<std::mutex> lock (mutex);
-	if (!stopped)
+	auto primary_block (blocks_a.first);
+	auto root (primary_block->root ());
+	std::shared_ptr<rai::election> election;
 	{
-		auto primary_block (blocks_a.first);
-		auto root (primary_block->root ());
-		auto existing (roots.find (root));
-		if (existing == roots.end ())
+		auto & shard_l (shard (root));
+		std::lock_guard<std::mutex> lock (shard_l.mutex);
+		if (!stopped)
 		{
-			auto election (std::make_shared<rai::election> (node, primary_block, confirmation_action_a));
-			roots.insert (rai::conflict_info{ root, election, 0, blocks_a });
-			successors.insert (std::make_pair (primary_block->hash (), election));
+			auto existing (shard_l.roots.find (root));
+			if (existing == shard_l.roots.end ())
+			{
+				election = std::make_shared<rai::election> (node, primary_block, confirmation_action_a);
+				auto now (std::chrono::steady_clock::now ());
+				shard_l.roots.insert (rai::conflict_info{ root, election, 0, blocks_a, now, now });
+			}
+			error = existing != shard_l.roots.end ();
 		}
-		error = existing != roots.end ();
+	}
+	if (election != nullptr)
+	{
+		successor_add (primary_block->hash (), election);
 	}
 	return error;
 }
@@ -3921,35 +5132,43 @@ bool rai::active_transactions::start (std::pair<std::shared_ptr<rai::block>, std
 // Validate a vote and apply it to the current election if one exists
 bool rai::active_transactions::vote (std::shared_ptr<rai::vote> vote_a)
 {
-	std::shared_ptr<rai::election> election;
 	bool replay (false);
 	bool processed (false);
-	{
-		std::lock_guard<std::mutex> lock (mutex);
-		for (auto vote_block : vote_a->blocks)
-		{
-			rai::election_vote_result result;
-			if (vote_block.which ())
+	for (auto vote_block : vote_a->blocks)
+	{
+		rai::election_vote_result result;
+		rai::block_hash block_hash;
+		std::shared_ptr<rai::election> election;
+		if (vote_block.which ())
+		{
+			block_hash = boost::get<rai::block_hash> (vote_block);
+			auto & shard_l (shard (block_hash));
+			std::lock_guard<std::mutex> lock (shard_l.mutex);
+			auto existing (shard_l.successors.find (block_hash));
+			if (existing != shard_l.successors.end ())
 			{
-				auto block_hash (boost::get<rai::block_hash> (vote_block));
-				auto existing (successors.find (block_hash));
-				if (existing != successors.end ())
-				{
-					result = existing->second->vote (vote_a->account, vote_a->sequence, block_hash);
-				}
+				election = existing->second;
 			}
-			else
+		}
+		else
+		{
+			auto block (boost::get<std::shared_ptr<rai::block>> (vote_block));
+			block_hash = block->hash ();
+			election = this->election (block->root ());
+		}
+		if (election != nullptr)
+		{
+			// Election state is guarded by the shard owning its root
+			auto & shard_l (shard (election->root));
+			std::lock_guard<std::mutex> lock (shard_l.mutex);
+			auto existing (shard_l.roots.find (election->root));
+			if (existing != shard_l.roots.end () && existing->election == election)
 			{
-				auto block (boost::get<std::shared_ptr<rai::block>> (vote_block));
-				auto existing (roots.find (block->root ()));
-				if (existing != roots.end ())
-				{
-					result = existing->election->vote (vote_a->account, vote_a->sequence, block->hash ());
-				}
+				result = election->vote (vote_a->account, vote_a->sequence, block_hash);
 			}
-			replay = replay || result.replay;
-			processed = processed || result.processed;
 		}
+		replay = replay || result.replay;
+		processed = processed || result.processed;
 	}
 	if (processed)
 	{
@@ -3960,28 +5179,73 @@ bool rai::active_transactions::vote (std::shared_ptr<rai::vote> vote_a)
 
 bool rai::active_transactions::active (rai::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return roots.find (block_a.root ()) != roots.end ();
+	return election (block_a.root ()) != nullptr;
+}
+
+std::shared_ptr<rai::election> rai::active_transactions::election (rai::block_hash const & root_a)
+{
+	std::shared_ptr<rai::election> result;
+	auto & shard_l (shard (root_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto existing (shard_l.roots.find (root_a));
+	if (existing != shard_l.roots.end ())
+	{
+		result = existing->election;
+	}
+	return result;
+}
+
+bool rai::active_transactions::conflict (rai::block_hash const & root_a, rai::conflict_info & info_a)
+{
+	auto & shard_l (shard (root_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto existing (shard_l.roots.find (root_a));
+	auto result (existing == shard_l.roots.end ());
+	if (!result)
+	{
+		info_a = *existing;
+	}
+	return result;
+}
+
+size_t rai::active_transactions::size ()
+{
+	size_t result (0);
+	for (auto & shard_l : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard_l.mutex);
+		result += shard_l.roots.size ();
+	}
+	return result;
+}
+
+bool rai::active_transactions::empty ()
+{
+	return size () == 0;
 }
 
 // List of active blocks in elections
 std::deque<std::shared_ptr<rai::block>> rai::active_transactions::list_blocks ()
 {
 	std::deque<std::shared_ptr<rai::block>> result;
-	std::lock_guard<std::mutex> lock (mutex);
-	for (auto i (roots.begin ()), n (roots.end ()); i != n; ++i)
+	for (auto & shard_l : shards)
 	{
-		result.push_back (i->election->status.winner);
+		std::lock_guard<std::mutex> lock (shard_l.mutex);
+		for (auto i (shard_l.roots.begin ()), n (shard_l.roots.end ()); i != n; ++i)
+		{
+			result.push_back (i->election->status.winner);
+		}
 	}
 	return result;
 }
 
 void rai::active_transactions::erase (rai::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	if (roots.find (block_a.root ()) != roots.end ())
+	auto & shard_l (shard (block_a.root ()));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	if (shard_l.roots.find (block_a.root ()) != shard_l.roots.end ())
 	{
-		roots.erase (block_a.root ());
+		shard_l.roots.erase (block_a.root ());
 		BOOST_LOG (node.log) << boost::str (boost::format ("Election erased for block block %1% root %2%") % block_a.hash ().to_string () % block_a.root ().to_string ());
 	}
 }
@@ -3999,19 +5263,32 @@ thread ([this]() { announce_loop (); })
 	}
 }
 
+rai::active_transactions::~active_transactions ()
+{
+	stop ();
+}
+
 bool rai::active_transactions::publish (std::shared_ptr<rai::block> block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	auto existing (roots.find (block_a->root ()));
 	auto result (true);
-	if (existing != roots.end ())
+	std::shared_ptr<rai::election> election;
 	{
-		result = existing->election->publish (block_a);
-		if (!result)
+		auto & shard_l (shard (block_a->root ()));
+		std::lock_guard<std::mutex> lock (shard_l.mutex);
+		auto existing (shard_l.roots.find (block_a->root ()));
+		if (existing != shard_l.roots.end ())
 		{
-			successors.insert (std::make_pair (block_a->hash (), existing->election));
+			result = existing->election->publish (block_a);
+			if (!result)
+			{
+				election = existing->election;
+			}
 		}
 	}
+	if (election != nullptr)
+	{
+		successor_add (block_a->hash (), election);
+	}
 	return result;
 }
 
@@ -6,6 +6,7 @@
 #include <rai/node/wallet.hpp>
 #include <rai/secure/ledger.hpp>
 
+#include <array>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -49,6 +50,8 @@ public:
 	std::chrono::steady_clock::time_point time;
 	uint64_t sequence;
 	rai::block_hash hash;
+	// Weight this vote contributes to the running tally for hash
+	rai::uint128_t weight;
 };
 class election_vote_result
 {
@@ -83,7 +86,11 @@ public:
 	rai::election_status status;
 	std::atomic<bool> confirmed;
 	bool aborted;
+	// Running weight total per block, adjusted as representatives change their vote
 	std::unordered_map<rai::block_hash, rai::uint128_t> last_tally;
+	// Peers already sent the full block in a confirm_req, later requests to them only carry its hash and root
+	// Only touched by the announce loop
+	std::unordered_set<rai::endpoint> confirm_req_sent;
 };
 class conflict_info
 {
@@ -93,6 +100,22 @@ public:
 	// Number of announcements in a row for this fork
 	unsigned announcements;
 	std::pair<std::shared_ptr<rai::block>, std::shared_ptr<rai::block>> confirm_req_options;
+	// Last time this election was announced, or when it started
+	std::chrono::steady_clock::time_point announced;
+	std::chrono::steady_clock::time_point started;
+};
+// Elections whose root falls in one partition of the root hash space
+class active_transactions_shard
+{
+public:
+	std::mutex mutex;
+	boost::multi_index_container<
+	rai::conflict_info,
+	boost::multi_index::indexed_by<
+	boost::multi_index::hashed_unique<boost::multi_index::member<rai::conflict_info, rai::block_hash, &rai::conflict_info::root>>>>
+	roots;
+	// Keyed by block hash, the shard is picked by the block hash rather than the election root
+	std::unordered_map<rai::block_hash, std::shared_ptr<rai::election>> successors;
 };
 // Core class for determining consensus
 // Holds all active blocks i.e. recently added blocks that need confirmation
@@ -100,6 +123,8 @@ class active_transactions
 {
 public:
 	active_transactions (rai::node &);
+	// Joins the announce thread when node construction fails after this member
+	~active_transactions ();
 	// Start an election for a block
 	// Call action with confirmed block, may be different than what we started with
 	bool start (std::shared_ptr<rai::block>, std::function<void(std::shared_ptr<rai::block>)> const & = [](std::shared_ptr<rai::block>) {});
@@ -112,34 +137,49 @@ public:
 	bool vote (std::shared_ptr<rai::vote>);
 	// Is the root of this block in the roots container
 	bool active (rai::block const &);
+	// Election for this root or nullptr if there isn't one
+	std::shared_ptr<rai::election> election (rai::block_hash const &);
+	// Copy out the conflict for this root, returns true if there isn't one
+	bool conflict (rai::block_hash const &, rai::conflict_info &);
+	size_t size ();
+	bool empty ();
 	std::deque<std::shared_ptr<rai::block>> list_blocks ();
 	void erase (rai::block const &);
 	void stop ();
 	bool publish (std::shared_ptr<rai::block> block_a);
-	boost::multi_index_container<
-	rai::conflict_info,
-	boost::multi_index::indexed_by<
-	boost::multi_index::hashed_unique<boost::multi_index::member<rai::conflict_info, rai::block_hash, &rai::conflict_info::root>>>>
-	roots;
-	std::unordered_map<rai::block_hash, std::shared_ptr<rai::election>> successors;
+	rai::active_transactions_shard & shard (rai::block_hash const &);
+	// Announcement order, higher first. Combines work difficulty, local wallet origin, vote weight seen so far and time waiting
+	double priority (MDB_txn *, rai::conflict_info const &, std::chrono::steady_clock::time_point const &);
+	// Time to wait before the next round given the number of elections waiting to be announced
+	std::chrono::milliseconds announce_interval (size_t);
+	static size_t constexpr shard_count = 16;
+	std::array<rai::active_transactions_shard, shard_count> shards;
 	std::deque<rai::election_status> confirmed;
 	rai::node & node;
+	// Protects confirmed and the announce loop state, never held while taking a shard lock
 	std::mutex mutex;
-	// Maximum number of conflicts to vote on per interval, lowest root hash first
+	// Elections announced per round, highest priority first
+	// Rounds run announce_interval_ms apart with this many waiting, fewer shorten the interval and more run rounds at the shortest one
 	static unsigned constexpr announcements_per_interval = 32;
-	// Minimum number of block announcements
+	// Minimum number of block announcements, finished elections are also kept announce_interval_ms for each past the first
 	static unsigned constexpr announcement_min = 2;
+	// Elections whose winner can't be applied to the ledger are aborted after this many announce_interval_ms
+	static unsigned constexpr could_fit_intervals = 4;
 	// Threshold to start logging blocks haven't yet been confirmed
 	static unsigned constexpr announcement_long = 20;
 	static unsigned constexpr announce_interval_ms = (rai::rai_network == rai::rai_networks::rai_test_network) ? 10 : 16000;
+	// Shortest interval, used while fewer than announcements_per_interval elections are waiting
+	static unsigned constexpr announce_interval_min_ms = (rai::rai_network == rai::rai_networks::rai_test_network) ? 10 : 2000;
 	static size_t constexpr election_history_size = 2048;
 
 private:
 	void announce_loop ();
-	void announce_votes ();
+	// Returns the number of elections waiting to be announced
+	size_t announce_votes ();
+	void successor_add (rai::block_hash const &, std::shared_ptr<rai::election>);
 	std::condition_variable condition;
 	bool started;
-	bool stopped;
+	std::atomic<bool> stopped;
 	std::thread thread;
 };
 class operation
@@ -358,6 +398,7 @@ public:
 	// Return `true' to indicated an error if the block has already been inserted
 	bool add (rai::block_hash const &);
 	bool recent (rai::block_hash const &);
+	void remove (rai::block_hash const &);
 	boost::multi_index_container<
 	rai::block_arrival_info,
 	boost::multi_index::indexed_by<
@@ -394,13 +435,56 @@ private:
 	std::mutex mutex;
 	rai::node & node;
 };
+// Datagram read by a batched receive
+class udp_buffer
+{
+public:
+	std::array<uint8_t, 512> data;
+	size_t size;
+	rai::endpoint endpoint;
+};
+// Datagram waiting in the batched send queue, data is kept alive by the callback
+class udp_send
+{
+public:
+	uint8_t const * data;
+	size_t size;
+	rai::endpoint endpoint;
+	std::function<void(boost::system::error_code const &, size_t)> callback;
+};
+// Whether this platform can read and write several datagrams per system call
+bool udp_batch_supported ();
+// Let several sockets bind the same port, returns true if the option couldn't be set
+bool udp_reuse_port (boost::asio::ip::udp::socket &);
+// Read pending datagrams into buffers without blocking, returns the number read
+size_t udp_receive_batch (boost::asio::ip::udp::socket &, std::vector<rai::udp_buffer> &, boost::system::error_code &);
+// Write datagrams without blocking, returns the number written before an error or a full socket buffer
+size_t udp_send_batch (boost::asio::ip::udp::socket &, std::vector<rai::udp_send> const &, boost::system::error_code &);
+class network;
+// Receive loop for one of the sockets bound to the peering port
+class udp_receiver
+{
+public:
+	udp_receiver (rai::network &, boost::asio::ip::udp::socket &, std::mutex &);
+	void receive ();
+	void receive_action (boost::system::error_code const &, size_t);
+	void receive_batch_action (boost::system::error_code const &);
+	rai::network & network;
+	boost::asio::ip::udp::socket & socket;
+	// Held while starting an operation on socket
+	std::mutex & socket_mutex;
+	rai::endpoint remote;
+	std::array<uint8_t, 512> buffer;
+	std::vector<rai::udp_buffer> buffers;
+};
 class network
 {
 public:
 	network (rai::node &, uint16_t);
 	void receive ();
 	void stop ();
-	void receive_action (boost::system::error_code const &, size_t);
+	void process_datagram (uint8_t const *, size_t, rai::endpoint const &);
+	void send_batch_action (boost::system::error_code const &);
 	void rpc_action (boost::system::error_code const &, size_t);
 	void republish_vote (std::shared_ptr<rai::vote>);
 	void republish_block (MDB_txn *, std::shared_ptr<rai::block>, bool = true);
@@ -412,16 +496,30 @@ public:
 	void send_node_id_handshake (rai::endpoint const &, boost::optional<rai::uint256_union> const & query, boost::optional<rai::uint256_union> const & respond_to);
 	void broadcast_confirm_req (std::shared_ptr<rai::block>);
 	void broadcast_confirm_req_base (std::shared_ptr<rai::block>, std::shared_ptr<std::vector<rai::peer_information>>, unsigned);
+	// Sends each peer its queued blocks, peers from confirm_req_hashes_version get up to confirm_req::roots_max per message and older peers one block per message
+	// Blocks paired with true are always sent whole, a peer that never received the block can't vote on its hash
+	void broadcast_confirm_req_batch (std::shared_ptr<std::unordered_map<rai::endpoint, std::vector<std::pair<std::shared_ptr<rai::block>, bool>>>>, unsigned = 50);
 	void send_confirm_req (rai::endpoint const &, std::shared_ptr<rai::block>);
+	void send_confirm_req_hashes (rai::endpoint const &, std::vector<std::pair<rai::block_hash, rai::block_hash>> const &);
+	void send_confirm_req (rai::endpoint const &, rai::confirm_req &);
 	void send_buffer (uint8_t const *, size_t, rai::endpoint const &, std::function<void(boost::system::error_code const &, size_t)>);
 	rai::endpoint endpoint ();
-	rai::endpoint remote;
-	std::array<uint8_t, 512> buffer;
 	boost::asio::ip::udp::socket socket;
 	std::mutex socket_mutex;
+	// Receive only sockets sharing the peering port through SO_REUSEPORT, the kernel spreads incoming datagrams across them
+	std::deque<boost::asio::ip::udp::socket> reuse_sockets;
+	std::deque<std::mutex> reuse_mutexes;
+	std::vector<std::unique_ptr<rai::udp_receiver>> receivers;
 	boost::asio::ip::udp::resolver resolver;
 	rai::node & node;
 	bool on;
+	// Read and write datagrams in batches instead of one asio operation per datagram
+	bool batch_io;
+	std::deque<rai::udp_send> send_queue;
+	rai::message_filter publish_filter;
+	bool sending;
+	static size_t constexpr udp_batch_size = 64;
+	static size_t constexpr publish_filter_size = 64 * 1024;
 	static uint16_t const node_port = rai::rai_network == rai::rai_networks::rai_live_network ? 7075 : 54000;
 };
 class logging
@@ -505,6 +603,28 @@ public:
 	uint16_t callback_port;
 	std::string callback_target;
 	int lmdb_max_dbs;
+	unsigned signature_checker_threads;
+	bool udp_batch_io;
+	// Sockets receiving on the peering port, more than one shares it through SO_REUSEPORT where supported
+	unsigned udp_sockets;
+	// Most blocks written by the block processor in one transaction
+	unsigned block_processor_batch_max;
+	// Target write transaction duration, including commit, while local or live blocks are waiting
+	std::chrono::milliseconds block_processor_live_latency;
+	// Target write transaction duration while only bootstrap blocks are waiting
+	std::chrono::milliseconds block_processor_bootstrap_latency;
+	// Unchecked blocks held in memory between store flushes, further blocks are written directly
+	size_t unchecked_cache_max;
+	// Unchecked blocks kept in total, blocks beyond this are dropped and fetched again by bootstrap
+	size_t unchecked_max;
+	// Unchecked blocks older than this are removed
+	std::chrono::seconds unchecked_cutoff;
+	// "lmdb" stores the ledger and wallets in the data directory. "volatile" keeps the ledger in an unsynced LMDB file
+	// under the system temporary directory, usually still on disk, that is deleted on shutdown. For benchmarks and
+	// simulations only, wallets can't be created in it since their keys would be deleted with it
+	std::string store_backend;
+	// Extra time a partial vote waits for more hashes, 0 signs as soon as the generator is free and only bundles hashes queued while it was busy
+	std::chrono::milliseconds vote_generator_delay;
 	rai::stat_config stat_config;
 	rai::uint256_union epoch_block_link;
 	rai::account epoch_block_signer;
@@ -524,12 +644,43 @@ public:
 	rai::observer_set<> disconnect;
 	rai::observer_set<> started;
 };
+// Signatures to be verified as one batch, verifications[i] is set to 1 when signature i is valid
+class signature_check_set
+{
+public:
+	void add (rai::uint256_union const &, rai::public_key const &, rai::signature const &);
+	size_t size () const;
+	std::vector<rai::uint256_union> messages;
+	std::vector<rai::public_key> pub_keys;
+	std::vector<rai::signature> signatures;
+	std::vector<int> verifications;
+};
+// Splits signature sets into batches and verifies them with the ed25519 batch verifier across a pool of threads
+class signature_checker
+{
+public:
+	signature_checker (unsigned);
+	~signature_checker ();
+	void verify (rai::signature_check_set &);
+	void stop ();
+	static size_t constexpr batch_size = 256;
+
+private:
+	void run ();
+	void verify_batch (rai::signature_check_set &, size_t, size_t);
+	bool stopped;
+	std::deque<std::function<void()>> tasks;
+	std::condition_variable condition;
+	std::mutex mutex;
+	std::vector<std::thread> threads;
+};
 class vote_processor
 {
 public:
 	vote_processor (rai::node &);
 	void vote (std::shared_ptr<rai::vote>, rai::endpoint);
-	rai::vote_code vote_blocking (MDB_txn *, std::shared_ptr<rai::vote>, rai::endpoint);
+	rai::vote_code vote_blocking (MDB_txn *, std::shared_ptr<rai::vote>, rai::endpoint, bool = false);
+	void verify_votes (std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> &);
 	void flush ();
 	rai::node & node;
 	void stop ();
@@ -544,6 +695,32 @@ private:
 	bool active;
 	std::thread thread;
 };
+// Collects hashes to vote on and has each local representative sign one vote by hash for up to confirm_ack::hashes_max of them
+class vote_generator
+{
+public:
+	vote_generator (rai::node &, std::chrono::milliseconds);
+	// Votes for the hash and processes the vote locally
+	void add (rai::block_hash const &);
+	// Votes for the hash and replies to the peer's confirm_req
+	void add (rai::block_hash const &, rai::endpoint const &);
+	void stop ();
+
+private:
+	void run ();
+	void send (std::unique_lock<std::mutex> &);
+	void push (rai::block_hash const &, boost::optional<rai::endpoint> const &);
+	rai::node & node;
+	std::mutex mutex;
+	std::condition_variable condition;
+	// Hashes with the peer asking for them, none for local votes
+	std::deque<std::pair<rai::block_hash, boost::optional<rai::endpoint>>> hashes;
+	// How long a partial vote waits for more hashes
+	std::chrono::milliseconds wait;
+	bool stopped;
+	bool started;
+	std::thread thread;
+};
 // The network is crawled for representatives by occasionally sending a unicast confirm_req for a specific block and watching to see if it's acknowledged with a vote.
 class rep_crawler
 {
@@ -554,8 +731,77 @@ public:
 	std::mutex mutex;
 	std::unordered_set<rai::block_hash> active;
 };
+enum class block_origin : uint8_t
+{
+	local, // Created by a wallet on this node or submitted over RPC
+	live, // Published by a peer
+	bootstrap // Pulled or pushed by a bootstrap connection
+};
+class block_processor_item
+{
+public:
+	std::shared_ptr<rai::block> block;
+	std::chrono::steady_clock::time_point origination;
+	rai::signature_verification verification;
+	rai::block_origin origin;
+};
+// One lane of the block processor queue. Sources take turns and each source's blocks are taken highest work difficulty first
+class block_queue_lane
+{
+public:
+	block_queue_lane (size_t);
+	// Returns the block dropped to stay within max, which may be the one being pushed, or nullptr
+	std::shared_ptr<rai::block> push (rai::block_processor_item const &, size_t, uint64_t);
+	rai::block_processor_item pop ();
+	bool empty () const;
+	size_t size () const;
+
+private:
+	std::unordered_map<size_t, std::multimap<uint64_t, rai::block_processor_item>> sources;
+	std::deque<size_t> turns;
+	size_t count;
+	size_t max;
+};
+// Sizes block processor write transactions from measured per-block processing time and commit latency
+class write_batch_controller
+{
+public:
+	write_batch_controller (size_t, size_t);
+	// Number of blocks expected to fit in a write transaction that should finish within the target
+	size_t batch_size (std::chrono::steady_clock::duration) const;
+	void record (size_t, std::chrono::steady_clock::duration, std::chrono::steady_clock::duration);
+	// Moving averages, zero until the first transaction has been recorded
+	std::chrono::steady_clock::duration per_block;
+	std::chrono::steady_clock::duration commit;
+	size_t min;
+	size_t max;
+};
+// Blocks waiting for signature pre-verification, with one bounded lane per origin
+// Local blocks are always taken first, live blocks are taken live_weight at a time for each bootstrap block while both are waiting
+class block_queue
+{
+public:
+	block_queue ();
+	std::shared_ptr<rai::block> push (rai::block_processor_item const &, size_t);
+	rai::block_processor_item pop ();
+	bool empty () const;
+	size_t size () const;
+	size_t size (rai::block_origin) const;
+	static size_t constexpr live_max = 16 * 1024;
+	static size_t constexpr bootstrap_max = 64 * 1024;
+	static unsigned constexpr live_weight = 4;
+
+private:
+	rai::block_queue_lane & lane (rai::block_origin);
+	rai::block_queue_lane const & lane (rai::block_origin) const;
+	rai::block_queue_lane local;
+	rai::block_queue_lane live;
+	rai::block_queue_lane bootstrap;
+	unsigned live_streak;
+};
 // Processing blocks is a potentially long IO operation
 // This class isolates block insertion from other operations like servicing network operations
+// Signature checks and signer lookups run on a verification thread against read transactions while the writer thread applies the previous batch
 class block_processor
 {
 public:
@@ -563,25 +809,47 @@ public:
 	~block_processor ();
 	void stop ();
 	void flush ();
+	// Bootstrap should wait before pulling more blocks
 	bool full ();
-	void add (std::shared_ptr<rai::block>, std::chrono::steady_clock::time_point);
+	// Source identifies the peer or connection the block came from so one source can't crowd out the others in its lane, 0 is never dropped
+	void add (std::shared_ptr<rai::block>, std::chrono::steady_clock::time_point, rai::block_origin = rai::block_origin::live, size_t = 0);
 	void force (std::shared_ptr<rai::block>);
 	bool should_log ();
-	bool have_blocks ();
+	// Writer thread, applies pre-verified blocks to the ledger
 	void process_blocks ();
-	rai::process_return process_receive_one (MDB_txn *, std::shared_ptr<rai::block>, std::chrono::steady_clock::time_point = std::chrono::steady_clock::now ());
+	// Verification thread, prepares the next batch for the writer
+	void verify_blocks ();
+	rai::process_return process_receive_one (MDB_txn *, std::shared_ptr<rai::block>, std::chrono::steady_clock::time_point = std::chrono::steady_clock::now (), rai::signature_verification = rai::signature_verification::unknown, rai::block_origin = rai::block_origin::local);
+	static size_t constexpr verification_max = 2048;
+	// Verification stops running ahead of the writer once this many blocks are waiting for it
+	static size_t constexpr checked_max = 2 * verification_max;
+	static size_t constexpr bootstrap_full = 16 * 1024;
+	static size_t constexpr batch_min = 64;
 
 private:
-	void queue_unchecked (MDB_txn *, rai::block_hash const &);
+	void queue_unchecked (MDB_txn *, rai::block_hash const &, rai::block_origin);
+	// Lets a dropped block be received and queued again
+	void forget (std::shared_ptr<rai::block>);
+	void verify_batch (std::unique_lock<std::mutex> &);
 	void process_receive_many (std::unique_lock<std::mutex> &);
+	// Local or live blocks are waiting, so write transactions should be kept short
+	bool live_waiting ();
 	bool stopped;
 	bool active;
+	bool verifying;
 	std::chrono::steady_clock::time_point next_log;
-	std::deque<std::pair<std::shared_ptr<rai::block>, std::chrono::steady_clock::time_point>> blocks;
+	// Blocks waiting for signature pre-verification
+	rai::block_queue blocks;
+	// Blocks that passed pre-verification, waiting for the write transaction
+	std::deque<rai::block_processor_item> checked;
+	// Entries in checked that didn't come from bootstrap
+	size_t checked_live;
 	std::unordered_set<rai::block_hash> blocks_hashes;
 	std::deque<std::shared_ptr<rai::block>> forced;
 	std::condition_variable condition;
 	rai::node & node;
+	// Only used by the processing thread
+	rai::write_batch_controller batch;
 	std::mutex mutex;
 };
 class node : public std::enable_shared_from_this<rai::node>
@@ -604,7 +872,7 @@ public:
 	int store_version ();
 	void process_confirmed (std::shared_ptr<rai::block>);
 	void process_message (rai::message &, rai::endpoint const &);
-	void process_active (std::shared_ptr<rai::block>);
+	void process_active (std::shared_ptr<rai::block>, rai::block_origin = rai::block_origin::live, size_t = 0);
 	rai::process_return process (rai::block const &);
 	void keepalive_preconfigured (std::vector<std::string> const &);
 	rai::block_hash latest (rai::account const &);
@@ -618,6 +886,9 @@ public:
 	void ongoing_rep_crawl ();
 	void ongoing_bootstrap ();
 	void ongoing_store_flush ();
+	void ongoing_unchecked_cleanup ();
+	// Removes unchecked blocks older than config.unchecked_cutoff, oldest first, returns the number removed
+	size_t unchecked_cleanup ();
 	void backup_wallet ();
 	int price (rai::uint128_t const &, int);
 	void work_generate_blocking (rai::block &);
@@ -632,6 +903,7 @@ public:
 	rai::alarm & alarm;
 	rai::work_pool & work;
 	boost::log::sources::logger_mt log;
+	rai::block_uniquer block_uniquer;
 	rai::block_store store;
 	rai::gap_cache gap_cache;
 	rai::ledger ledger;
@@ -644,11 +916,14 @@ public:
 	rai::node_observers observers;
 	rai::wallets wallets;
 	rai::port_mapping port_mapping;
+	rai::signature_checker checker;
 	rai::vote_processor vote_processor;
+	rai::vote_generator vote_generator;
 	rai::rep_crawler rep_crawler;
 	unsigned warmed_up;
 	rai::block_processor block_processor;
 	std::thread block_processor_thread;
+	std::thread block_verification_thread;
 	rai::block_arrival block_arrival;
 	rai::online_reps online_reps;
 	rai::stat stats;
@@ -659,6 +934,10 @@ public:
 	static std::chrono::seconds constexpr cutoff = period * 5;
 	static std::chrono::seconds constexpr syn_cookie_cutoff = std::chrono::seconds (5);
 	static std::chrono::minutes constexpr backup_interval = std::chrono::minutes (5);
+	// Entries read per read transaction and deleted per write transaction by unchecked_cleanup
+	static size_t constexpr unchecked_cleanup_batch = 1024;
+	// Expired entries held in memory per pass over the unchecked table
+	static size_t constexpr unchecked_cleanup_max = 64 * 1024;
 };
 class thread_runner
 {
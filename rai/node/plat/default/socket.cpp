@@ -0,0 +1,24 @@
+#include <rai/node/node.hpp>
+
+bool rai::udp_batch_supported ()
+{
+	return false;
+}
+
+bool rai::udp_reuse_port (boost::asio::ip::udp::socket &)
+{
+	// SO_REUSEPORT doesn't balance datagrams across sockets everywhere, receive on a single socket
+	return true;
+}
+
+size_t rai::udp_receive_batch (boost::asio::ip::udp::socket &, std::vector<rai::udp_buffer> &, boost::system::error_code & ec_a)
+{
+	ec_a = boost::asio::error::operation_not_supported;
+	return 0;
+}
+
+size_t rai::udp_send_batch (boost::asio::ip::udp::socket &, std::vector<rai::udp_send> const &, boost::system::error_code & ec_a)
+{
+	ec_a = boost::asio::error::operation_not_supported;
+	return 0;
+}
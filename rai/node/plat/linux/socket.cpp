@@ -0,0 +1,75 @@
+#include <rai/node/node.hpp>
+
+#include <sys/socket.h>
+
+bool rai::udp_batch_supported ()
+{
+	return true;
+}
+
+bool rai::udp_reuse_port (boost::asio::ip::udp::socket & socket_a)
+{
+	int enable (1);
+	return setsockopt (socket_a.native_handle (), SOL_SOCKET, SO_REUSEPORT, &enable, sizeof (enable)) != 0;
+}
+
+size_t rai::udp_receive_batch (boost::asio::ip::udp::socket & socket_a, std::vector<rai::udp_buffer> & buffers_a, boost::system::error_code & ec_a)
+{
+	std::vector<mmsghdr> messages (buffers_a.size ());
+	std::vector<iovec> iovecs (buffers_a.size ());
+	for (size_t i (0), n (buffers_a.size ()); i < n; ++i)
+	{
+		auto & buffer (buffers_a[i]);
+		iovecs[i].iov_base = buffer.data.data ();
+		iovecs[i].iov_len = buffer.data.size ();
+		messages[i] = mmsghdr ();
+		messages[i].msg_hdr.msg_name = buffer.endpoint.data ();
+		messages[i].msg_hdr.msg_namelen = buffer.endpoint.capacity ();
+		messages[i].msg_hdr.msg_iov = &iovecs[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	size_t result (0);
+	auto count (recvmmsg (socket_a.native_handle (), messages.data (), messages.size (), MSG_DONTWAIT, nullptr));
+	if (count < 0)
+	{
+		ec_a = boost::system::error_code (errno, boost::asio::error::get_system_category ());
+	}
+	else
+	{
+		result = count;
+		for (size_t i (0); i < result; ++i)
+		{
+			buffers_a[i].size = messages[i].msg_len;
+			buffers_a[i].endpoint.resize (messages[i].msg_hdr.msg_namelen);
+		}
+	}
+	return result;
+}
+
+size_t rai::udp_send_batch (boost::asio::ip::udp::socket & socket_a, std::vector<rai::udp_send> const & datagrams_a, boost::system::error_code & ec_a)
+{
+	std::vector<mmsghdr> messages (datagrams_a.size ());
+	std::vector<iovec> iovecs (datagrams_a.size ());
+	for (size_t i (0), n (datagrams_a.size ()); i < n; ++i)
+	{
+		auto & datagram (datagrams_a[i]);
+		iovecs[i].iov_base = const_cast<uint8_t *> (datagram.data);
+		iovecs[i].iov_len = datagram.size;
+		messages[i] = mmsghdr ();
+		messages[i].msg_hdr.msg_name = const_cast<sockaddr *> (datagram.endpoint.data ());
+		messages[i].msg_hdr.msg_namelen = datagram.endpoint.size ();
+		messages[i].msg_hdr.msg_iov = &iovecs[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	size_t result (0);
+	auto count (sendmmsg (socket_a.native_handle (), messages.data (), messages.size (), MSG_DONTWAIT));
+	if (count < 0)
+	{
+		ec_a = boost::system::error_code (errno, boost::asio::error::get_system_category ());
+	}
+	else
+	{
+		result = count;
+	}
+	return result;
+}
@@ -1346,19 +1346,34 @@ void rai::rpc_handler::chain (bool successors)
 	{
 		boost::property_tree::ptree blocks;
 		rai::transaction transaction (node.store.environment, nullptr, false);
-		while (!hash.is_zero () && blocks.size () < count)
+		rai::block_sideband sideband;
+		if (!node.store.block_sideband_get (transaction, hash, sideband))
 		{
-			auto block_l (node.store.block_get (transaction, hash));
-			if (block_l != nullptr)
+			// Both directions are a single scan of the account's heights, predecessors are read upwards and listed in reverse
+			auto low (sideband.height);
+			if (!successors)
 			{
-				boost::property_tree::ptree entry;
-				entry.put ("", hash.to_string ());
-				blocks.push_back (std::make_pair ("", entry));
-				hash = successors ? node.store.block_successor (transaction, hash) : block_l->previous ();
+				low = sideband.height > count ? sideband.height - count + 1 : 1;
 			}
-			else
+			std::vector<rai::block_hash> hashes;
+			for (auto i (node.store.heights_begin (transaction, sideband.account, low)), n (node.store.heights_end ()); i != n && hashes.size () < count; ++i)
+			{
+				rai::height_key key (i->first);
+				if (key.account != sideband.account || (!successors && key.height > sideband.height))
+				{
+					break;
+				}
+				hashes.push_back (rai::block_hash (i->second));
+			}
+			if (!successors)
 			{
-				hash.clear ();
+				std::reverse (hashes.begin (), hashes.end ());
+			}
+			for (auto & hash_l : hashes)
+			{
+				boost::property_tree::ptree entry;
+				entry.put ("", hash_l.to_string ());
+				blocks.push_back (std::make_pair ("", entry));
 			}
 		}
 		response_l.add_child ("blocks", blocks);
@@ -1386,21 +1401,33 @@ void rai::rpc_handler::confirmation_history ()
 void rai::rpc_handler::delegators ()
 {
 	auto account (account_impl ());
+	auto count (count_optional_impl ());
+	rai::account start (0);
+	boost::optional<std::string> start_text (request.get_optional<std::string> ("start"));
+	if (!ec && start_text.is_initialized ())
+	{
+		if (start.decode_account (start_text.get ()))
+		{
+			ec = nano::error_common::bad_account_number;
+		}
+	}
 	if (!ec)
 	{
 		boost::property_tree::ptree delegators;
 		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		for (auto i (node.store.delegators_begin (transaction, account, start)), n (node.store.delegators_end ()); i != n && delegators.size () < count; ++i)
 		{
-			rai::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
+			rai::delegator_key key (i->first);
+			if (key.representative != account)
 			{
-				std::string balance;
-				rai::uint128_union (info.balance).encode_dec (balance);
-				delegators.put (rai::account (i->first).to_account (), balance);
+				break;
 			}
+			rai::account_info info;
+			auto error (node.store.account_get (transaction, key.account, info));
+			assert (!error);
+			std::string balance;
+			rai::uint128_union (info.balance).encode_dec (balance);
+			delegators.put (key.account.to_account (), balance);
 		}
 		response_l.add_child ("delegators", delegators);
 	}
@@ -1414,15 +1441,9 @@ void rai::rpc_handler::delegators_count ()
 	{
 		uint64_t count (0);
 		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		for (auto i (node.store.delegators_begin (transaction, account)), n (node.store.delegators_end ()); i != n && rai::delegator_key (i->first).representative == account; ++i)
 		{
-			rai::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
-			{
-				++count;
-			}
+			++count;
 		}
 		response_l.put ("count", std::to_string (count));
 	}
@@ -1658,21 +1679,34 @@ void rai::rpc_handler::account_history ()
 		{
 			boost::property_tree::ptree history;
 			response_l.put ("account", account.to_account ());
-			auto block (node.store.block_get (transaction, hash));
-			while (block != nullptr && count > 0)
+			rai::block_sideband sideband;
+			auto error (node.store.block_sideband_get (transaction, hash, sideband));
+			hash.clear ();
+			if (!error && offset < sideband.height)
 			{
-				if (offset > 0)
+				// The page is the heights [low, top] of the account chain, read with one forward scan and listed newest first
+				auto top (sideband.height - offset);
+				auto low (top > count ? top - count + 1 : 1);
+				std::vector<rai::block_hash> hashes;
+				for (auto i (node.store.heights_begin (transaction, sideband.account, low)), n (node.store.heights_end ()); i != n; ++i)
 				{
-					--offset;
+					rai::height_key key (i->first);
+					if (key.account != sideband.account || key.height > top)
+					{
+						break;
+					}
+					hashes.push_back (rai::block_hash (i->second));
 				}
-				else
+				for (auto j (hashes.rbegin ()), m (hashes.rend ()); j != m; ++j)
 				{
+					auto block (node.store.block_get (transaction, *j));
+					assert (block != nullptr);
 					boost::property_tree::ptree entry;
-					history_visitor visitor (*this, output_raw, transaction, entry, hash);
+					history_visitor visitor (*this, output_raw, transaction, entry, *j);
 					block->visit (visitor);
 					if (!entry.empty ())
 					{
-						entry.put ("hash", hash.to_string ());
+						entry.put ("hash", j->to_string ());
 						if (output_raw)
 						{
 							entry.put ("work", rai::to_string_hex (block->block_work ()));
@@ -1680,10 +1714,8 @@ void rai::rpc_handler::account_history ()
 						}
 						history.push_back (std::make_pair ("", entry));
 					}
-					--count;
+					hash = block->previous ();
 				}
-				hash = block->previous ();
-				block = node.store.block_get (transaction, hash);
 			}
 			response_l.add_child ("history", history);
 			if (!hash.is_zero ())
@@ -2699,11 +2731,10 @@ void rai::rpc_handler::unchecked ()
 		rai::transaction transaction (node.store.environment, nullptr, false);
 		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
 		{
-			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-			auto block (rai::deserialize_block (stream));
+			rai::unchecked_info info (i->second);
 			std::string contents;
-			block->serialize_json (contents);
-			unchecked.put (block->hash ().to_string (), contents);
+			info.block->serialize_json (contents);
+			unchecked.put (info.block->hash ().to_string (), contents);
 		}
 		response_l.add_child ("blocks", unchecked);
 	}
@@ -2730,13 +2761,14 @@ void rai::rpc_handler::unchecked_get ()
 		rai::transaction transaction (node.store.environment, nullptr, false);
 		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n; ++i)
 		{
-			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-			auto block (rai::deserialize_block (stream));
-			if (block->hash () == hash)
+			rai::unchecked_key key (i->first);
+			if (key.hash == hash)
 			{
+				rai::unchecked_info info (i->second);
 				std::string contents;
-				block->serialize_json (contents);
+				info.block->serialize_json (contents);
 				response_l.put ("contents", contents);
+				response_l.put ("modified_timestamp", std::to_string (info.modified));
 				break;
 			}
 		}
@@ -2764,15 +2796,16 @@ void rai::rpc_handler::unchecked_keys ()
 	{
 		boost::property_tree::ptree unchecked;
 		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+		for (auto i (node.store.unchecked_begin (transaction, rai::unchecked_key (key, 0))), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
 		{
 			boost::property_tree::ptree entry;
-			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-			auto block (rai::deserialize_block (stream));
+			rai::unchecked_key key_l (i->first);
+			rai::unchecked_info info (i->second);
 			std::string contents;
-			block->serialize_json (contents);
-			entry.put ("key", rai::block_hash (i->first).to_string ());
-			entry.put ("hash", block->hash ().to_string ());
+			info.block->serialize_json (contents);
+			entry.put ("key", key_l.previous.to_string ());
+			entry.put ("hash", key_l.hash.to_string ());
+			entry.put ("modified_timestamp", std::to_string (info.modified));
 			entry.put ("contents", contents);
 			unchecked.push_back (std::make_pair ("", entry));
 		}
@@ -343,6 +343,9 @@ std::string rai::stat::type_to_string (uint32_t key)
 		case rai::stat::type::message:
 			res = "message";
 			break;
+		case rai::stat::type::filter:
+			res = "filter";
+			break;
 	}
 	return res;
 }
@@ -389,6 +392,15 @@ std::string rai::stat::detail_to_string (uint32_t key)
 		case rai::stat::detail::handshake:
 			res = "handshake";
 			break;
+		case rai::stat::detail::duplicate_message:
+			res = "duplicate_message";
+			break;
+		case rai::stat::detail::queue_overflow:
+			res = "queue_overflow";
+			break;
+		case rai::stat::detail::unchecked_overflow:
+			res = "unchecked_overflow";
+			break;
 		case rai::stat::detail::initiate:
 			res = "initiate";
 			break;
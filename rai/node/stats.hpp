@@ -184,7 +184,8 @@ public:
 		rollback,
 		bootstrap,
 		vote,
-		peering
+		peering,
+		filter
 	};
 
 	/** Optional detail type */
@@ -227,6 +228,13 @@ public:
 
 		// peering
 		handshake,
+
+		// duplicate filter
+		duplicate_message,
+
+		// block processor
+		queue_overflow,
+		unchecked_overflow,
 	};
 
 	/** Direction of the stat. If the direction is irrelevant, use in */
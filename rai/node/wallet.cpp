@@ -905,7 +905,7 @@ std::shared_ptr<rai::block> rai::wallet::receive_action (rai::block const & send
 		{
 			node.work_generate_blocking (*block);
 		}
-		node.process_active (block);
+		node.process_active (block, rai::block_origin::local);
 		node.block_processor.flush ();
 		if (generate_work_a)
 		{
@@ -943,7 +943,7 @@ std::shared_ptr<rai::block> rai::wallet::change_action (rai::account const & sou
 		{
 			node.work_generate_blocking (*block);
 		}
-		node.process_active (block);
+		node.process_active (block, rai::block_origin::local);
 		node.block_processor.flush ();
 		if (generate_work_a)
 		{
@@ -1025,7 +1025,7 @@ std::shared_ptr<rai::block> rai::wallet::send_action (rai::account const & sourc
 		{
 			node.work_generate_blocking (*block);
 		}
-		node.process_active (block);
+		node.process_active (block, rai::block_origin::local);
 		node.block_processor.flush ();
 		if (generate_work_a)
 		{
@@ -1272,17 +1272,25 @@ std::shared_ptr<rai::wallet> rai::wallets::create (rai::uint256_union const & id
 {
 	assert (items.find (id_a) == items.end ());
 	std::shared_ptr<rai::wallet> result;
-	bool error;
+	// A volatile store is deleted on shutdown, keys and seeds kept in it would be lost
+	if (node.store.environment.durable)
 	{
-		rai::transaction transaction (node.store.environment, nullptr, true);
-		result = std::make_shared<rai::wallet> (error, transaction, node, id_a.to_string ());
+		bool error;
+		{
+			rai::transaction transaction (node.store.environment, nullptr, true);
+			result = std::make_shared<rai::wallet> (error, transaction, node, id_a.to_string ());
+		}
+		if (!error)
+		{
+			items[id_a] = result;
+			node.background ([result]() {
+				result->enter_initial_password ();
+			});
+		}
 	}
-	if (!error)
+	else
 	{
-		items[id_a] = result;
-		node.background ([result]() {
-			result->enter_initial_password ();
-		});
+		BOOST_LOG (node.log) << "Refusing to create a wallet in a volatile store";
 	}
 	return result;
 }
@@ -1899,7 +1899,7 @@ wallet (wallet_a)
 			{
 				show_label_ok (*status);
 				this->status->setText ("");
-				this->wallet.node.process_active (std::move (block_l));
+				this->wallet.node.process_active (std::move (block_l), rai::block_origin::local);
 			}
 			else
 			{
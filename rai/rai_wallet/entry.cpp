@@ -218,7 +218,12 @@ int run_wallet (QApplication & application, int argc, char * const * argv, boost
 		rai::alarm alarm (service);
 		rai::node_init init;
 		node = std::make_shared<rai::node> (init, service, data_path, alarm, config.node, work);
-		if (!init.error ())
+		if (!init.error () && !node->store.environment.durable)
+		{
+			// The wallet needs somewhere to keep its keys
+			show_error ("The volatile store_backend can't hold wallets, use lmdb");
+		}
+		else if (!init.error ())
 		{
 			auto wallet (node->wallets.open (config.wallet));
 			if (wallet == nullptr)
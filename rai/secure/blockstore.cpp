@@ -19,14 +19,7 @@ public:
 	virtual ~block_predecessor_set () = default;
 	void fill_value (rai::block const & block_a)
 	{
-		auto hash (block_a.hash ());
-		rai::block_type type;
-		auto value (store.block_raw_get (transaction, block_a.previous (), type));
-		auto version (store.block_version (transaction, block_a.previous ()));
-		assert (value.mv_size != 0);
-		std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
-		std::copy (hash.bytes.begin (), hash.bytes.end (), data.end () - hash.bytes.size ());
-		store.block_raw_put (transaction, store.block_database (type, version), block_a.previous (), rai::mdb_val (data.size (), data.data ()));
+		store.block_successor_set (transaction, block_a.previous (), block_a.hash ());
 	}
 	void send_block (rai::send_block const & block_a) override
 	{
@@ -435,20 +428,26 @@ bool rai::store_iterator::operator!= (rai::store_iterator const & other_a) const
 	return !(*this == other_a);
 }
 
-rai::store_iterator rai::block_store::block_info_begin (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+rai::store_iterator rai::block_store::block_begin (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	return rai::store_iterator (std::make_unique<rai::store_iterator_impl> (transaction_a, blocks_info, rai::mdb_val (hash_a)));
+	return rai::store_iterator (std::make_unique<rai::store_iterator_impl> (transaction_a, blocks, rai::mdb_val (hash_a)));
 }
 
-rai::store_iterator rai::block_store::block_info_begin (MDB_txn * transaction_a)
+rai::store_iterator rai::block_store::block_end ()
 {
-	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (transaction_a, blocks_info));
+	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (nullptr));
 	return result;
 }
 
-rai::store_iterator rai::block_store::block_info_end ()
+rai::store_iterator rai::block_store::heights_begin (MDB_txn * transaction_a, rai::account const & account_a, uint64_t height_a)
 {
-	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (nullptr));
+	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (transaction_a, heights, rai::mdb_val (rai::height_key (account_a, height_a))));
+	return result;
+}
+
+rai::store_iterator rai::block_store::heights_end ()
+{
+	rai::store_iterator result (nullptr);
 	return result;
 }
 
@@ -464,15 +463,27 @@ rai::store_iterator rai::block_store::representation_end ()
 	return result;
 }
 
+rai::store_iterator rai::block_store::delegators_begin (MDB_txn * transaction_a, rai::account const & representative_a, rai::account const & start_a)
+{
+	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (transaction_a, delegators, rai::mdb_val (rai::delegator_key (representative_a, start_a))));
+	return result;
+}
+
+rai::store_iterator rai::block_store::delegators_end ()
+{
+	rai::store_iterator result (nullptr);
+	return result;
+}
+
 rai::store_iterator rai::block_store::unchecked_begin (MDB_txn * transaction_a)
 {
 	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (transaction_a, unchecked));
 	return result;
 }
 
-rai::store_iterator rai::block_store::unchecked_begin (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+rai::store_iterator rai::block_store::unchecked_begin (MDB_txn * transaction_a, rai::unchecked_key const & key_a)
 {
-	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (transaction_a, unchecked, rai::mdb_val (hash_a)));
+	rai::store_iterator result (std::make_unique<rai::store_iterator_impl> (transaction_a, unchecked, rai::mdb_val (key_a)));
 	return result;
 }
 
@@ -492,50 +503,238 @@ rai::store_iterator rai::block_store::vote_end ()
 	return rai::store_iterator (nullptr);
 }
 
-rai::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, int lmdb_max_dbs) :
-environment (error_a, path_a, lmdb_max_dbs),
+size_t constexpr rai::block_filter::bucket_size;
+size_t constexpr rai::block_filter::max_kicks;
+
+rai::block_filter::block_filter (size_t capacity_a) :
+count (0),
+sequence (0),
+victim (0),
+victim_index (0)
+{
+	size_t buckets (1);
+	while (buckets * bucket_size < capacity_a)
+	{
+		buckets <<= 1;
+	}
+	mask = buckets - 1;
+	// Atomics can't be moved so the zeroed table is built in place
+	std::vector<std::atomic<uint16_t>> table_l (buckets * bucket_size);
+	table.swap (table_l);
+}
+
+uint16_t rai::block_filter::fingerprint (rai::block_hash const & hash_a) const
+{
+	// Block hashes are uniformly distributed so their words can be used directly
+	uint16_t result (hash_a.qwords[1] & 0xffff);
+	return result != 0 ? result : 1;
+}
+
+size_t rai::block_filter::index (rai::block_hash const & hash_a) const
+{
+	return hash_a.qwords[0] & mask;
+}
+
+size_t rai::block_filter::alternate (size_t index_a, uint16_t fingerprint_a) const
+{
+	return (index_a ^ (static_cast<size_t> (fingerprint_a) * 0x5bd1e995)) & mask;
+}
+
+bool rai::block_filter::bucket_insert (size_t index_a, uint16_t fingerprint_a)
+{
+	auto result (false);
+	for (size_t i (index_a * bucket_size), n (i + bucket_size); i != n && !result; ++i)
+	{
+		if (table[i] == 0)
+		{
+			table[i] = fingerprint_a;
+			result = true;
+		}
+	}
+	return result;
+}
+
+bool rai::block_filter::bucket_erase (size_t index_a, uint16_t fingerprint_a)
+{
+	auto result (false);
+	for (size_t i (index_a * bucket_size), n (i + bucket_size); i != n && !result; ++i)
+	{
+		if (table[i] == fingerprint_a)
+		{
+			table[i] = 0;
+			result = true;
+		}
+	}
+	return result;
+}
+
+bool rai::block_filter::bucket_contains (size_t index_a, uint16_t fingerprint_a) const
+{
+	auto result (false);
+	for (size_t i (index_a * bucket_size), n (i + bucket_size); i != n && !result; ++i)
+	{
+		result = table[i] == fingerprint_a;
+	}
+	return result;
+}
+
+bool rai::block_filter::insert (rai::block_hash const & hash_a)
+{
+	auto result (victim != 0);
+	if (!result)
+	{
+		// Kicked fingerprints are missing from the table until placed again
+		++sequence;
+		auto fingerprint_l (fingerprint (hash_a));
+		auto index_l (index (hash_a));
+		if (!bucket_insert (index_l, fingerprint_l) && !bucket_insert (alternate (index_l, fingerprint_l), fingerprint_l))
+		{
+			// Both buckets are full, displace existing fingerprints to their alternate buckets
+			auto placed (false);
+			for (size_t kick (0); kick < max_kicks && !placed; ++kick)
+			{
+				auto & slot (table[index_l * bucket_size + (kick + fingerprint_l) % bucket_size]);
+				fingerprint_l = slot.exchange (fingerprint_l);
+				index_l = alternate (index_l, fingerprint_l);
+				placed = bucket_insert (index_l, fingerprint_l);
+			}
+			if (!placed)
+			{
+				victim_index = index_l;
+				victim = fingerprint_l;
+			}
+		}
+		++count;
+		++sequence;
+	}
+	return result;
+}
+
+void rai::block_filter::erase (rai::block_hash const & hash_a)
+{
+	auto fingerprint_l (fingerprint (hash_a));
+	auto index_l (index (hash_a));
+	auto alternate_l (alternate (index_l, fingerprint_l));
+	++sequence;
+	if (victim == fingerprint_l && (victim_index == index_l || victim_index == alternate_l))
+	{
+		victim = 0;
+	}
+	else
+	{
+		auto erased (bucket_erase (index_l, fingerprint_l) || bucket_erase (alternate_l, fingerprint_l));
+		assert (erased);
+		// A slot is free again, move the victim back into the table
+		if (victim != 0 && bucket_insert (victim_index, victim))
+		{
+			victim = 0;
+		}
+	}
+	assert (count > 0);
+	--count;
+	++sequence;
+}
+
+bool rai::block_filter::may_contain (rai::block_hash const & hash_a) const
+{
+	auto fingerprint_l (fingerprint (hash_a));
+	auto index_l (index (hash_a));
+	auto alternate_l (alternate (index_l, fingerprint_l));
+	auto result (false);
+	auto retry (true);
+	while (retry)
+	{
+		auto sequence_l (sequence.load ());
+		result = bucket_contains (index_l, fingerprint_l) || bucket_contains (alternate_l, fingerprint_l);
+		if (!result && victim == fingerprint_l)
+		{
+			result = victim_index == index_l || victim_index == alternate_l;
+		}
+		// A hit is always right, a miss only if no write overlapped the lookup
+		retry = !result && ((sequence_l & 1) != 0 || sequence.load () != sequence_l);
+	}
+	return result;
+}
+
+size_t rai::block_filter::size () const
+{
+	return count;
+}
+
+size_t rai::block_filter::capacity () const
+{
+	return table.size ();
+}
+
+size_t constexpr rai::block_store::unchecked_cache_max_default;
+size_t constexpr rai::block_store::unchecked_max_default;
+size_t constexpr rai::block_store::filter_headroom;
+
+rai::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, int lmdb_max_dbs, bool durable_a) :
+unchecked_cache_max (unchecked_cache_max_default),
+unchecked_max (unchecked_max_default),
+environment (error_a, path_a, lmdb_max_dbs, durable_a),
 frontiers (0),
 accounts_v0 (0),
 accounts_v1 (0),
-send_blocks (0),
-receive_blocks (0),
-open_blocks (0),
-change_blocks (0),
-state_blocks_v0 (0),
-state_blocks_v1 (0),
+blocks (0),
+heights (0),
 pending_v0 (0),
 pending_v1 (0),
-blocks_info (0),
 representation (0),
+representation_cache (std::make_shared<std::unordered_map<rai::account, rai::uint128_t>> ()),
+staged_writer (std::thread::id ()),
+delegators (0),
 unchecked (0),
 checksum (0),
 vote (0),
 meta (0)
 {
+	environment.commit_observer = [this](MDB_txn * transaction_a, MDB_txn * parent_a) {
+		// Transactions on other threads never staged anything
+		if (staged_writer.load () == std::this_thread::get_id ())
+		{
+			representation_commit (transaction_a, parent_a);
+			block_count_commit (transaction_a, parent_a);
+			if (representation_staged.empty () && block_count_staged.empty ())
+			{
+				staged_writer.store (std::thread::id ());
+			}
+		}
+	};
 	if (!error_a)
 	{
 		rai::transaction transaction (environment, nullptr, true);
 		error_a |= mdb_dbi_open (transaction, "frontiers", MDB_CREATE, &frontiers) != 0;
 		error_a |= mdb_dbi_open (transaction, "accounts", MDB_CREATE, &accounts_v0) != 0;
 		error_a |= mdb_dbi_open (transaction, "accounts_v1", MDB_CREATE, &accounts_v1) != 0;
-		error_a |= mdb_dbi_open (transaction, "send", MDB_CREATE, &send_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "receive", MDB_CREATE, &receive_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "open", MDB_CREATE, &open_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "change", MDB_CREATE, &change_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "state", MDB_CREATE, &state_blocks_v0) != 0;
-		error_a |= mdb_dbi_open (transaction, "state_v1", MDB_CREATE, &state_blocks_v1) != 0;
+		error_a |= mdb_dbi_open (transaction, "blocks", MDB_CREATE, &blocks) != 0;
+		error_a |= mdb_dbi_open (transaction, "heights", MDB_CREATE, &heights) != 0;
 		error_a |= mdb_dbi_open (transaction, "pending", MDB_CREATE, &pending_v0) != 0;
 		error_a |= mdb_dbi_open (transaction, "pending_v1", MDB_CREATE, &pending_v1) != 0;
-		error_a |= mdb_dbi_open (transaction, "blocks_info", MDB_CREATE, &blocks_info) != 0;
 		error_a |= mdb_dbi_open (transaction, "representation", MDB_CREATE, &representation) != 0;
-		error_a |= mdb_dbi_open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked) != 0;
+		error_a |= mdb_dbi_open (transaction, "delegators", MDB_CREATE, &delegators) != 0;
+		error_a |= mdb_dbi_open (transaction, "unchecked", MDB_CREATE, &unchecked) != 0;
 		error_a |= mdb_dbi_open (transaction, "checksum", MDB_CREATE, &checksum) != 0;
 		error_a |= mdb_dbi_open (transaction, "vote", MDB_CREATE, &vote) != 0;
 		error_a |= mdb_dbi_open (transaction, "meta", MDB_CREATE, &meta) != 0;
 		if (!error_a)
 		{
+			auto cache (std::make_shared<std::unordered_map<rai::account, rai::uint128_t>> ());
+			for (auto i (representation_begin (transaction)), n (representation_end ()); i != n; ++i)
+			{
+				rai::uint128_union weight (i->second);
+				if (!weight.is_zero ())
+				{
+					(*cache)[rai::account (i->first)] = weight.number ();
+				}
+			}
+			std::atomic_store (&representation_cache, std::shared_ptr<std::unordered_map<rai::account, rai::uint128_t> const> (cache));
 			do_upgrades (transaction);
 			checksum_put (transaction, 0, 0, 0);
+			// Start at most half full so a growing ledger doesn't rebuild straight away
+			auto count (block_count (transaction).sum ());
+			std::atomic_store (&filter, filter_build (transaction, std::max<size_t> (2 * count, count + filter_headroom)));
 		}
 	}
 }
@@ -545,9 +744,10 @@ void rai::block_store::initialize (MDB_txn * transaction_a, rai::genesis const &
 	auto hash_l (genesis_a.hash ());
 	assert (latest_v0_begin (transaction_a) == latest_v0_end ());
 	assert (latest_v1_begin (transaction_a) == latest_v1_end ());
-	block_put (transaction_a, hash_l, *genesis_a.open);
+	block_put (transaction_a, hash_l, *genesis_a.open, rai::block_sideband (genesis_account, 0, std::numeric_limits<rai::uint128_t>::max (), 1, rai::seconds_since_epoch ()));
 	account_put (transaction_a, genesis_account, { hash_l, genesis_a.open->hash (), genesis_a.open->hash (), std::numeric_limits<rai::uint128_t>::max (), rai::seconds_since_epoch (), 1, rai::epoch::epoch_0 });
 	representation_put (transaction_a, genesis_account, std::numeric_limits<rai::uint128_t>::max ());
+	delegator_put (transaction_a, genesis_account, genesis_account);
 	checksum_put (transaction_a, 0, 0, hash_l);
 	frontier_put (transaction_a, hash_l, genesis_account);
 }
@@ -609,7 +809,13 @@ void rai::block_store::delete_node_id (MDB_txn * transaction_a)
 
 void rai::block_store::do_upgrades (MDB_txn * transaction_a)
 {
-	switch (version_get (transaction_a))
+	auto version (version_get (transaction_a));
+	if (version < 11)
+	{
+		// Earlier upgrades walk account chains, which requires blocks to be in the unified table
+		block_tables_merge (transaction_a);
+	}
+	switch (version)
 	{
 		case 1:
 			upgrade_v1_to_v2 (transaction_a);
@@ -632,6 +838,16 @@ void rai::block_store::do_upgrades (MDB_txn * transaction_a)
 		case 10:
 			upgrade_v10_to_v11 (transaction_a);
 		case 11:
+			upgrade_v11_to_v12 (transaction_a);
+		case 12:
+			upgrade_v12_to_v13 (transaction_a);
+		case 13:
+			upgrade_v13_to_v14 (transaction_a);
+		case 14:
+			upgrade_v14_to_v15 (transaction_a);
+		case 15:
+			upgrade_v15_to_v16 (transaction_a);
+		case 16:
 			break;
 		default:
 			assert (false);
@@ -676,6 +892,8 @@ void rai::block_store::upgrade_v2_to_v3 (MDB_txn * transaction_a)
 {
 	version_put (transaction_a, 3);
 	mdb_drop (transaction_a, representation, 0);
+	std::atomic_store (&representation_cache, std::shared_ptr<std::unordered_map<rai::account, rai::uint128_t> const> (std::make_shared<std::unordered_map<rai::account, rai::uint128_t>> ()));
+	representation_staged.erase (transaction_a);
 	for (auto i (latest_v0_begin (transaction_a)), n (latest_v0_end ()); i != n; ++i)
 	{
 		rai::account account_l (i->first);
@@ -721,7 +939,7 @@ void rai::block_store::upgrade_v4_to_v5 (MDB_txn * transaction_a)
 			if (block_successor (transaction_a, hash).is_zero () && !successor.is_zero ())
 			{
 				//std::cerr << boost::str (boost::format ("Adding successor for account %1%, block %2%, successor %3%\n") % account.to_account () % hash.to_string () % successor.to_string ());
-				block_put (transaction_a, hash, *block, successor);
+				block_successor_set (transaction_a, hash, successor);
 			}
 			successor = hash;
 			block = block_get (transaction_a, block->previous ());
@@ -797,41 +1015,144 @@ void rai::block_store::upgrade_v8_to_v9 (MDB_txn * transaction_a)
 
 void rai::block_store::upgrade_v9_to_v10 (MDB_txn * transaction_a)
 {
-	//std::cerr << boost::str (boost::format ("Performing database upgrade to version 10...\n"));
+	// Used to populate blocks_info, which was replaced by block sideband in version 13
 	version_put (transaction_a, 10);
-	for (auto i (latest_v0_begin (transaction_a)), n (latest_v0_end ()); i != n; ++i)
+}
+
+void rai::block_store::upgrade_v10_to_v11 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 11);
+	MDB_dbi unsynced;
+	mdb_dbi_open (transaction_a, "unsynced", MDB_CREATE | MDB_DUPSORT, &unsynced);
+	mdb_drop (transaction_a, unsynced, 1);
+}
+
+void rai::block_store::upgrade_v11_to_v12 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 12);
+	block_tables_merge (transaction_a);
+}
+
+void rai::block_store::upgrade_v12_to_v13 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 13);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
 	{
+		rai::account account (i->first);
 		rai::account_info info (i->second);
-		if (info.block_count >= block_info_max)
+		uint64_t height (1);
+		// Walk forward from the open block so each balance lookup finds the previous block's sideband
+		auto hash (info.open_block);
+		while (!hash.is_zero ())
 		{
-			rai::account account (i->first);
-			//std::cerr << boost::str (boost::format ("Upgrading account %1%...\n") % account.to_account ());
-			size_t block_count (1);
-			auto hash (info.open_block);
-			while (!hash.is_zero ())
+			rai::block_sideband sideband;
+			auto block (block_get (transaction_a, hash, &sideband));
+			assert (block != nullptr);
+			auto successor (block_successor (transaction_a, hash));
+			if (sideband.height == 0)
 			{
-				if ((block_count % block_info_max) == 0)
-				{
-					rai::block_info block_info;
-					block_info.account = account;
-					rai::amount balance (block_balance (transaction_a, hash));
-					block_info.balance = balance;
-					block_info_put (transaction_a, hash, block_info);
-				}
-				hash = block_successor (transaction_a, hash);
-				++block_count;
+				rai::block_sideband upgraded (account, successor, block_balance (transaction_a, hash), height, 0);
+				block_put (transaction_a, hash, *block, upgraded, block_version (transaction_a, hash));
 			}
+			hash = successor;
+			++height;
 		}
 	}
-	//std::cerr << boost::str (boost::format ("Database upgrade is completed\n"));
+	MDB_dbi blocks_info;
+	mdb_dbi_open (transaction_a, "blocks_info", MDB_CREATE, &blocks_info);
+	mdb_drop (transaction_a, blocks_info, 1);
 }
 
-void rai::block_store::upgrade_v10_to_v11 (MDB_txn * transaction_a)
+void rai::block_store::upgrade_v13_to_v14 (MDB_txn * transaction_a)
 {
-	version_put (transaction_a, 11);
-	MDB_dbi unsynced;
-	mdb_dbi_open (transaction_a, "unsynced", MDB_CREATE | MDB_DUPSORT, &unsynced);
-	mdb_drop (transaction_a, unsynced, 1);
+	// Unchecked entries are keyed by dependency and block hash instead of duplicates under the dependency, they are refetched by bootstrap
+	version_put (transaction_a, 14);
+	mdb_drop (transaction_a, unchecked, 1);
+	mdb_dbi_open (transaction_a, "unchecked", MDB_CREATE, &unchecked);
+}
+
+void rai::block_store::upgrade_v14_to_v15 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 15);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		rai::account_info info (i->second);
+		auto block (block_get (transaction_a, info.rep_block));
+		assert (block != nullptr);
+		delegator_put (transaction_a, block->representative (), rai::account (i->first));
+	}
+}
+
+void rai::block_store::upgrade_v15_to_v16 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 16);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		rai::account account (i->first);
+		rai::account_info info (i->second);
+		uint64_t height (1);
+		for (auto hash (info.open_block); !hash.is_zero (); hash = block_successor (transaction_a, hash))
+		{
+			auto status (mdb_put (transaction_a, heights, rai::mdb_val (rai::height_key (account, height)), rai::mdb_val (hash), 0));
+			assert (status == 0);
+			++height;
+		}
+	}
+}
+
+void rai::block_store::block_tables_merge (MDB_txn * transaction_a)
+{
+	// Blocks used to be split across one table per block type and epoch
+	std::array<std::tuple<char const *, rai::block_type, rai::epoch>, 6> tables = { { std::make_tuple ("send", rai::block_type::send, rai::epoch::epoch_0),
+	std::make_tuple ("receive", rai::block_type::receive, rai::epoch::epoch_0),
+	std::make_tuple ("open", rai::block_type::open, rai::epoch::epoch_0),
+	std::make_tuple ("change", rai::block_type::change, rai::epoch::epoch_0),
+	std::make_tuple ("state", rai::block_type::state, rai::epoch::epoch_0),
+	std::make_tuple ("state_v1", rai::block_type::state, rai::epoch::epoch_1) } };
+	for (auto & table : tables)
+	{
+		MDB_dbi legacy;
+		auto status (mdb_dbi_open (transaction_a, std::get<0> (table), MDB_CREATE, &legacy));
+		assert (status == 0);
+		int64_t count (0);
+		for (rai::store_iterator i (std::make_unique<rai::store_iterator_impl> (transaction_a, legacy)), n (nullptr); i != n; ++i)
+		{
+			std::vector<uint8_t> vector;
+			{
+				rai::vectorstream stream (vector);
+				rai::write (stream, std::get<1> (table));
+				rai::write (stream, static_cast<uint8_t> (std::get<2> (table)));
+			}
+			auto data (static_cast<uint8_t *> (i->second.data ()));
+			vector.insert (vector.end (), data, data + i->second.size ());
+			auto status2 (mdb_put (transaction_a, blocks, i->first, rai::mdb_val (vector.size (), vector.data ()), MDB_NOOVERWRITE));
+			assert (status2 == 0 || status2 == MDB_KEYEXIST);
+			if (status2 == 0)
+			{
+				++count;
+			}
+		}
+		auto status3 (mdb_drop (transaction_a, legacy, 1));
+		assert (status3 == 0);
+		block_count_add (transaction_a, std::get<1> (table), std::get<2> (table), count);
+	}
+}
+
+std::shared_ptr<rai::block_filter> rai::block_store::filter_build (MDB_txn * transaction_a, size_t capacity_a)
+{
+	auto filter_l (std::make_shared<rai::block_filter> (capacity_a));
+	for (rai::store_iterator i (std::make_unique<rai::store_iterator_impl> (transaction_a, blocks)), n (nullptr); i != n; ++i)
+	{
+		auto error (filter_l->insert (rai::block_hash (i->first)));
+		if (error)
+		{
+			// Unlucky placement, try again with more room
+			filter_l = std::make_shared<rai::block_filter> (2 * filter_l->capacity ());
+			i = rai::store_iterator (std::make_unique<rai::store_iterator_impl> (transaction_a, blocks));
+			filter_l->insert (rai::block_hash (i->first));
+		}
+	}
+	return filter_l;
 }
 
 void rai::block_store::clear (MDB_dbi db_a)
@@ -851,9 +1172,14 @@ rai::uint128_t rai::block_store::block_balance (MDB_txn * transaction_a, rai::bl
 rai::epoch rai::block_store::block_version (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
 	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, state_blocks_v1, rai::mdb_val (hash_a), value));
+	auto status (mdb_get (transaction_a, blocks, rai::mdb_val (hash_a), value));
 	assert (status == 0 || status == MDB_NOTFOUND);
-	return status == 0 ? rai::epoch::epoch_1 : rai::epoch::epoch_0;
+	auto result (rai::epoch::epoch_0);
+	if (status == 0)
+	{
+		result = static_cast<rai::epoch> (static_cast<uint8_t const *> (value.data ())[1]);
+	}
+	return result;
 }
 
 void rai::block_store::representation_add (MDB_txn * transaction_a, rai::block_hash const & source_a, rai::uint128_t const & amount_a)
@@ -865,67 +1191,60 @@ void rai::block_store::representation_add (MDB_txn * transaction_a, rai::block_h
 	representation_put (transaction_a, source_rep, source_previous + amount_a);
 }
 
-MDB_dbi rai::block_store::block_database (rai::block_type type_a, rai::epoch epoch_a)
+void rai::block_store::block_raw_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, MDB_val value_a)
 {
-	if (type_a == rai::block_type::state)
-	{
-		assert (epoch_a == rai::epoch::epoch_0 || epoch_a == rai::epoch::epoch_1);
-	}
-	else
-	{
-		assert (epoch_a == rai::epoch::epoch_0);
-	}
-	MDB_dbi result;
-	switch (type_a)
-	{
-		case rai::block_type::send:
-			result = send_blocks;
-			break;
-		case rai::block_type::receive:
-			result = receive_blocks;
-			break;
-		case rai::block_type::open:
-			result = open_blocks;
-			break;
-		case rai::block_type::change:
-			result = change_blocks;
-			break;
-		case rai::block_type::state:
-			switch (epoch_a)
-			{
-				case rai::epoch::epoch_0:
-					result = state_blocks_v0;
-					break;
-				case rai::epoch::epoch_1:
-					result = state_blocks_v1;
-					break;
-				default:
-					assert (false);
-			}
-			break;
-		default:
-			assert (false);
-			break;
-	}
-	return result;
+	auto status2 (mdb_put (transaction_a, blocks, rai::mdb_val (hash_a), &value_a, 0));
+	assert (status2 == 0);
 }
 
-void rai::block_store::block_raw_put (MDB_txn * transaction_a, MDB_dbi database_a, rai::block_hash const & hash_a, MDB_val value_a)
+void rai::block_store::block_successor_set (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_hash const & successor_a)
 {
-	auto status2 (mdb_put (transaction_a, database_a, rai::mdb_val (hash_a), &value_a, 0));
-	assert (status2 == 0);
+	rai::block_type type;
+	auto value (block_raw_get (transaction_a, hash_a, type));
+	assert (value.mv_size != 0);
+	std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
+	std::copy (successor_a.bytes.begin (), successor_a.bytes.end (), data.end () - successor_a.bytes.size ());
+	block_raw_put (transaction_a, hash_a, rai::mdb_val (data.size (), data.data ()));
 }
 
-void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a, rai::block_hash const & successor_a, rai::epoch epoch_a)
+void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a, rai::block_sideband const & sideband_a, rai::epoch epoch_a)
 {
-	assert (successor_a.is_zero () || block_exists (transaction_a, successor_a));
+	assert (sideband_a.successor.is_zero () || block_exists (transaction_a, sideband_a.successor));
+	assert (block_a.type () == rai::block_type::state ? epoch_a == rai::epoch::epoch_0 || epoch_a == rai::epoch::epoch_1 : epoch_a == rai::epoch::epoch_0);
 	std::vector<uint8_t> vector;
 	{
 		rai::vectorstream stream (vector);
+		rai::write (stream, block_a.type ());
+		rai::write (stream, static_cast<uint8_t> (epoch_a));
 		block_a.serialize (stream);
-		rai::write (stream, successor_a.bytes);
+		sideband_a.serialize (stream);
+	}
+	rai::mdb_val value (vector.size (), vector.data ());
+	auto status (mdb_put (transaction_a, blocks, rai::mdb_val (hash_a), value, MDB_NOOVERWRITE));
+	if (status == MDB_KEYEXIST)
+	{
+		status = mdb_put (transaction_a, blocks, rai::mdb_val (hash_a), value, 0);
+	}
+	else
+	{
+		block_count_add (transaction_a, block_a.type (), epoch_a, 1);
+		auto filter_l (std::atomic_load (&filter));
+		if (filter_l != nullptr && filter_l->insert (hash_a))
+		{
+			// Readers answer from the database while the larger filter is built, only this write transaction changes the blocks table meanwhile
+			auto capacity (2 * filter_l->capacity ());
+			std::atomic_store (&filter, std::shared_ptr<rai::block_filter> ());
+			// The new block is already in the table so the rebuilt filter includes it
+			std::atomic_store (&filter, filter_build (transaction_a, capacity));
+		}
+	}
+	assert (status == 0);
+	// Sideband is left empty by callers outside the ledger, those blocks aren't part of an account chain
+	if (sideband_a.height != 0)
+	{
+		status = mdb_put (transaction_a, heights, rai::mdb_val (rai::height_key (sideband_a.account, sideband_a.height)), rai::mdb_val (hash_a), 0);
+		assert (status == 0);
 	}
-	block_raw_put (transaction_a, block_database (block_a.type (), epoch_a), hash_a, { vector.size (), vector.data () });
 	rai::block_predecessor_set predecessor (transaction_a, *this);
 	block_a.visit (predecessor);
 	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
@@ -934,125 +1253,29 @@ void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const
 MDB_val rai::block_store::block_raw_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_type & type_a)
 {
 	rai::mdb_val result;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), result));
+	auto status (mdb_get (transaction_a, blocks, rai::mdb_val (hash_a), result));
 	assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
-	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), result));
-		assert (status == 0 || status == MDB_NOTFOUND);
-		if (status != 0)
-		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), result));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			if (status != 0)
-			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), result));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				if (status != 0)
-				{
-					auto status (mdb_get (transaction_a, state_blocks_v0, rai::mdb_val (hash_a), result));
-					assert (status == 0 || status == MDB_NOTFOUND);
-					if (status != 0)
-					{
-						auto status (mdb_get (transaction_a, state_blocks_v1, rai::mdb_val (hash_a), result));
-						assert (status == 0 || status == MDB_NOTFOUND);
-						if (status != 0)
-						{
-							// Block not found
-						}
-						else
-						{
-							type_a = rai::block_type::state;
-						}
-					}
-					else
-					{
-						type_a = rai::block_type::state;
-					}
-				}
-				else
-				{
-					type_a = rai::block_type::change;
-				}
-			}
-			else
-			{
-				type_a = rai::block_type::open;
-			}
-		}
-		else
-		{
-			type_a = rai::block_type::receive;
-		}
-	}
-	else
+	if (status == 0)
 	{
-		type_a = rai::block_type::send;
+		assert (result.size () > block_prefix_size);
+		type_a = static_cast<rai::block_type> (static_cast<uint8_t const *> (result.data ())[0]);
 	}
 	return result;
 }
 
-std::unique_ptr<rai::block> rai::block_store::block_random (MDB_txn * transaction_a, MDB_dbi database)
+std::unique_ptr<rai::block> rai::block_store::block_random (MDB_txn * transaction_a)
 {
 	rai::block_hash hash;
 	rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
-	rai::store_iterator existing (std::make_unique<rai::store_iterator_impl> (transaction_a, database, rai::mdb_val (hash)));
+	rai::store_iterator existing (std::make_unique<rai::store_iterator_impl> (transaction_a, blocks, rai::mdb_val (hash)));
 	if (existing == rai::store_iterator (nullptr))
 	{
-		existing = rai::store_iterator (std::make_unique<rai::store_iterator_impl> (transaction_a, database));
+		existing = rai::store_iterator (std::make_unique<rai::store_iterator_impl> (transaction_a, blocks));
 	}
 	assert (existing != rai::store_iterator (nullptr));
 	return block_get (transaction_a, rai::block_hash (existing->first));
 }
 
-std::unique_ptr<rai::block> rai::block_store::block_random (MDB_txn * transaction_a)
-{
-	auto count (block_count (transaction_a));
-	auto region (rai::random_pool.GenerateWord32 (0, count.sum () - 1));
-	std::unique_ptr<rai::block> result;
-	if (region < count.send)
-	{
-		result = block_random (transaction_a, send_blocks);
-	}
-	else
-	{
-		region -= count.send;
-		if (region < count.receive)
-		{
-			result = block_random (transaction_a, receive_blocks);
-		}
-		else
-		{
-			region -= count.receive;
-			if (region < count.open)
-			{
-				result = block_random (transaction_a, open_blocks);
-			}
-			else
-			{
-				region -= count.open;
-				if (region < count.change)
-				{
-					result = block_random (transaction_a, change_blocks);
-				}
-				else
-				{
-					region -= count.change;
-					if (region < count.state_v0)
-					{
-						result = block_random (transaction_a, state_blocks_v0);
-					}
-					else
-					{
-						result = block_random (transaction_a, state_blocks_v1);
-					}
-				}
-			}
-		}
-	}
-	return result;
-}
-
 rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
 	rai::block_type type;
@@ -1074,126 +1297,178 @@ rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai:
 
 void rai::block_store::block_successor_clear (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto block (block_get (transaction_a, hash_a));
-	auto version (block_version (transaction_a, hash_a));
-	block_put (transaction_a, hash_a, *block, 0, version);
+	block_successor_set (transaction_a, hash_a, 0);
 }
 
-std::unique_ptr<rai::block> rai::block_store::block_get (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+std::unique_ptr<rai::block> rai::block_store::block_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_sideband * sideband_a)
 {
 	rai::block_type type;
 	auto value (block_raw_get (transaction_a, hash_a, type));
 	std::unique_ptr<rai::block> result;
 	if (value.mv_size != 0)
 	{
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data) + block_prefix_size, value.mv_size - block_prefix_size);
 		result = rai::deserialize_block (stream, type);
 		assert (result != nullptr);
+		if (sideband_a != nullptr && stream.in_avail () == rai::block_sideband::size)
+		{
+			auto error (sideband_a->deserialize (stream));
+			assert (!error);
+		}
 	}
 	return result;
 }
 
+bool rai::block_store::block_sideband_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_sideband & sideband_a)
+{
+	rai::block_type type;
+	auto value (block_raw_get (transaction_a, hash_a, type));
+	auto result (true);
+	// Blocks waiting for the version 13 upgrade are stored with only a successor after them
+	if (value.mv_size == block_prefix_size + block_size (type) + rai::block_sideband::size)
+	{
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data) + value.mv_size - rai::block_sideband::size, rai::block_sideband::size);
+		result = sideband_a.deserialize (stream);
+		assert (!result);
+		// Heights start at 1, a zero height is the empty sideband written by block_put callers outside the ledger
+		result = result || sideband_a.height == 0;
+	}
+	return result;
+}
+
+size_t rai::block_store::block_size (rai::block_type type_a)
+{
+	return rai::block_size (type_a);
+}
+
 void rai::block_store::block_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto status (mdb_del (transaction_a, state_blocks_v1, rai::mdb_val (hash_a), nullptr));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
+	rai::block_type type;
+	auto value (block_raw_get (transaction_a, hash_a, type));
+	assert (value.mv_size != 0);
+	auto epoch (static_cast<rai::epoch> (static_cast<uint8_t const *> (value.mv_data)[1]));
+	rai::block_sideband sideband;
+	if (value.mv_size == block_prefix_size + block_size (type) + rai::block_sideband::size)
 	{
-		auto status (mdb_del (transaction_a, state_blocks_v0, rai::mdb_val (hash_a), nullptr));
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data) + value.mv_size - rai::block_sideband::size, rai::block_sideband::size);
+		auto error (sideband.deserialize (stream));
+		assert (!error);
+	}
+	auto status (mdb_del (transaction_a, blocks, rai::mdb_val (hash_a), nullptr));
+	assert (status == 0);
+	if (sideband.height != 0)
+	{
+		status = mdb_del (transaction_a, heights, rai::mdb_val (rai::height_key (sideband.account, sideband.height)), nullptr);
 		assert (status == 0 || status == MDB_NOTFOUND);
-		if (status != 0)
-		{
-			auto status (mdb_del (transaction_a, send_blocks, rai::mdb_val (hash_a), nullptr));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			if (status != 0)
-			{
-				auto status (mdb_del (transaction_a, receive_blocks, rai::mdb_val (hash_a), nullptr));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				if (status != 0)
-				{
-					auto status (mdb_del (transaction_a, open_blocks, rai::mdb_val (hash_a), nullptr));
-					assert (status == 0 || status == MDB_NOTFOUND);
-					if (status != 0)
-					{
-						auto status (mdb_del (transaction_a, change_blocks, rai::mdb_val (hash_a), nullptr));
-						assert (status == 0);
-					}
-				}
-			}
-		}
+	}
+	block_count_add (transaction_a, type, epoch, -1);
+	auto filter_l (std::atomic_load (&filter));
+	if (filter_l != nullptr)
+	{
+		filter_l->erase (hash_a);
 	}
 }
 
 bool rai::block_store::block_exists (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto exists (true);
-	rai::mdb_val junk;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), junk));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	exists = status == 0;
-	if (!exists)
+	// No filter while upgrades rewrite the tables
+	auto filter_l (std::atomic_load (&filter));
+	auto result (filter_l == nullptr || filter_l->may_contain (hash_a));
+	// Most hashes arriving from the network are new, those are answered without touching the database
+	if (result)
 	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), junk));
+		rai::mdb_val junk;
+		auto status (mdb_get (transaction_a, blocks, rai::mdb_val (hash_a), junk));
 		assert (status == 0 || status == MDB_NOTFOUND);
-		exists = status == 0;
-		if (!exists)
-		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), junk));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			if (!exists)
-			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), junk));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				exists = status == 0;
-				if (!exists)
-				{
-					auto status (mdb_get (transaction_a, state_blocks_v0, rai::mdb_val (hash_a), junk));
-					assert (status == 0 || status == MDB_NOTFOUND);
-					exists = status == 0;
-					if (!exists)
-					{
-						auto status (mdb_get (transaction_a, state_blocks_v1, rai::mdb_val (hash_a), junk));
-						assert (status == 0 || status == MDB_NOTFOUND);
-						exists = status == 0;
-					}
-				}
-			}
-		}
+		result = status == 0;
 	}
-	return exists;
+	return result;
 }
 
 rai::block_counts rai::block_store::block_count (MDB_txn * transaction_a)
 {
+	rai::uint256_union block_count_key (4);
 	rai::block_counts result;
-	MDB_stat send_stats;
-	auto status1 (mdb_stat (transaction_a, send_blocks, &send_stats));
-	assert (status1 == 0);
-	MDB_stat receive_stats;
-	auto status2 (mdb_stat (transaction_a, receive_blocks, &receive_stats));
-	assert (status2 == 0);
-	MDB_stat open_stats;
-	auto status3 (mdb_stat (transaction_a, open_blocks, &open_stats));
-	assert (status3 == 0);
-	MDB_stat change_stats;
-	auto status4 (mdb_stat (transaction_a, change_blocks, &change_stats));
-	assert (status4 == 0);
-	MDB_stat state_v0_stats;
-	auto status5 (mdb_stat (transaction_a, state_blocks_v0, &state_v0_stats));
-	assert (status5 == 0);
-	MDB_stat state_v1_stats;
-	auto status6 (mdb_stat (transaction_a, state_blocks_v1, &state_v1_stats));
-	assert (status6 == 0);
-	result.send = send_stats.ms_entries;
-	result.receive = receive_stats.ms_entries;
-	result.open = open_stats.ms_entries;
-	result.change = change_stats.ms_entries;
-	result.state_v0 = state_v0_stats.ms_entries;
-	result.state_v1 = state_v1_stats.ms_entries;
+	rai::mdb_val value;
+	auto status (mdb_get (transaction_a, meta, rai::mdb_val (block_count_key), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	if (status == 0)
+	{
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+		auto error (result.deserialize (stream));
+		assert (!error);
+	}
+	if (staged_writer.load () == std::this_thread::get_id ())
+	{
+		auto staged (block_count_staged.find (transaction_a));
+		if (staged != block_count_staged.end ())
+		{
+			result.add (staged->second);
+		}
+	}
 	return result;
 }
 
+void rai::block_store::block_count_add (MDB_txn * transaction_a, rai::block_type type_a, rai::epoch epoch_a, int64_t amount_a)
+{
+	staged_writer.store (std::this_thread::get_id ());
+	// Removals wrap around and cancel out when added to the stored counts
+	auto & counts (block_count_staged[transaction_a]);
+	switch (type_a)
+	{
+		case rai::block_type::send:
+			counts.send += amount_a;
+			break;
+		case rai::block_type::receive:
+			counts.receive += amount_a;
+			break;
+		case rai::block_type::open:
+			counts.open += amount_a;
+			break;
+		case rai::block_type::change:
+			counts.change += amount_a;
+			break;
+		case rai::block_type::state:
+			if (epoch_a == rai::epoch::epoch_1)
+			{
+				counts.state_v1 += amount_a;
+			}
+			else
+			{
+				counts.state_v0 += amount_a;
+			}
+			break;
+		default:
+			assert (false);
+			break;
+	}
+}
+
+void rai::block_store::block_count_commit (MDB_txn * transaction_a, MDB_txn * parent_a)
+{
+	auto staged (block_count_staged.find (transaction_a));
+	if (staged != block_count_staged.end ())
+	{
+		if (parent_a != nullptr)
+		{
+			block_count_staged[parent_a].add (staged->second);
+		}
+		else
+		{
+			auto counts (block_count (transaction_a));
+			std::vector<uint8_t> vector;
+			{
+				rai::vectorstream stream (vector);
+				counts.serialize (stream);
+			}
+			rai::uint256_union block_count_key (4);
+			auto status (mdb_put (transaction_a, meta, rai::mdb_val (block_count_key), rai::mdb_val (vector.size (), vector.data ()), 0));
+			assert (status == 0);
+		}
+		block_count_staged.erase (staged);
+	}
+}
+
 bool rai::block_store::root_exists (MDB_txn * transaction_a, rai::uint256_union const & root_a)
 {
 	return block_exists (transaction_a, root_a) || account_exists (transaction_a, root_a);
@@ -1452,100 +1727,143 @@ rai::store_merge_iterator rai::block_store::pending_end ()
 	return result;
 }
 
-void rai::block_store::block_info_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_info const & block_info_a)
+rai::uint128_t rai::block_store::representation_get (MDB_txn * transaction_a, rai::account const & account_a)
 {
-	auto status (mdb_put (transaction_a, blocks_info, rai::mdb_val (hash_a), rai::mdb_val (block_info_a), 0));
-	assert (status == 0);
+	rai::uint128_t result (0);
+	auto found (false);
+	// Readers on other threads can't hold the write transaction, they go straight to the committed snapshot
+	if (staged_writer.load () == std::this_thread::get_id ())
+	{
+		auto staged (representation_staged.find (transaction_a));
+		if (staged != representation_staged.end ())
+		{
+			auto existing (staged->second.find (account_a));
+			if (existing != staged->second.end ())
+			{
+				result = existing->second;
+				found = true;
+			}
+		}
+	}
+	if (!found)
+	{
+		auto cache (std::atomic_load (&representation_cache));
+		auto existing (cache->find (account_a));
+		if (existing != cache->end ())
+		{
+			result = existing->second;
+		}
+	}
+	return result;
 }
 
-void rai::block_store::block_info_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+void rai::block_store::representation_put (MDB_txn * transaction_a, rai::account const & account_a, rai::uint128_t const & representation_a)
 {
-	auto status (mdb_del (transaction_a, blocks_info, rai::mdb_val (hash_a), nullptr));
+	rai::uint128_union rep (representation_a);
+	auto status (mdb_put (transaction_a, representation, rai::mdb_val (account_a), rai::mdb_val (rep), 0));
 	assert (status == 0);
+	// Other readers keep seeing the committed weight until this transaction commits
+	staged_writer.store (std::this_thread::get_id ());
+	representation_staged[transaction_a][account_a] = representation_a;
 }
 
-bool rai::block_store::block_info_exists (MDB_txn * transaction_a, rai::block_hash const & hash_a)
-{
-	auto iterator (block_info_begin (transaction_a, hash_a));
-	return iterator != rai::store_iterator (nullptr) && rai::block_hash (iterator->first) == hash_a;
-}
-
-bool rai::block_store::block_info_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_info & block_info_a)
+void rai::block_store::representation_commit (MDB_txn * transaction_a, MDB_txn * parent_a)
 {
-	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, blocks_info, rai::mdb_val (hash_a), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	bool result;
-	if (status == MDB_NOTFOUND)
+	auto staged (representation_staged.find (transaction_a));
+	if (staged != representation_staged.end ())
 	{
-		result = true;
-	}
-	else
-	{
-		result = false;
-		assert (value.size () == sizeof (block_info_a.account.bytes) + sizeof (block_info_a.balance.bytes));
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		auto error1 (rai::read (stream, block_info_a.account));
-		assert (!error1);
-		auto error2 (rai::read (stream, block_info_a.balance));
-		assert (!error2);
+		if (parent_a != nullptr)
+		{
+			auto & parent (representation_staged[parent_a]);
+			for (auto & i : staged->second)
+			{
+				parent[i.first] = i.second;
+			}
+		}
+		else
+		{
+			// Swapped in as one snapshot so readers see all of a transaction's weights or none
+			auto cache (std::make_shared<std::unordered_map<rai::account, rai::uint128_t>> (*std::atomic_load (&representation_cache)));
+			for (auto & i : staged->second)
+			{
+				if (i.second == 0)
+				{
+					cache->erase (i.first);
+				}
+				else
+				{
+					(*cache)[i.first] = i.second;
+				}
+			}
+			std::atomic_store (&representation_cache, std::shared_ptr<std::unordered_map<rai::account, rai::uint128_t> const> (cache));
+		}
+		representation_staged.erase (staged);
 	}
-	return result;
 }
 
-rai::uint128_t rai::block_store::representation_get (MDB_txn * transaction_a, rai::account const & account_a)
+void rai::block_store::delegator_put (MDB_txn * transaction_a, rai::account const & representative_a, rai::account const & account_a)
 {
-	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, representation, rai::mdb_val (account_a), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	rai::uint128_t result;
-	if (status == 0)
-	{
-		rai::uint128_union rep;
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		auto error (rai::read (stream, rep));
-		assert (!error);
-		result = rep.number ();
-	}
-	else
-	{
-		result = 0;
-	}
-	return result;
+	auto status (mdb_put (transaction_a, delegators, rai::mdb_val (rai::delegator_key (representative_a, account_a)), rai::mdb_val (), 0));
+	assert (status == 0);
 }
 
-void rai::block_store::representation_put (MDB_txn * transaction_a, rai::account const & account_a, rai::uint128_t const & representation_a)
+void rai::block_store::delegator_del (MDB_txn * transaction_a, rai::account const & representative_a, rai::account const & account_a)
 {
-	rai::uint128_union rep (representation_a);
-	auto status (mdb_put (transaction_a, representation, rai::mdb_val (account_a), rai::mdb_val (rep), 0));
-	assert (status == 0);
+	auto status (mdb_del (transaction_a, delegators, rai::mdb_val (rai::delegator_key (representative_a, account_a)), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
 }
 
 void rai::block_store::unchecked_clear (MDB_txn * transaction_a)
 {
+	{
+		std::lock_guard<std::mutex> lock (cache_mutex);
+		unchecked_cache.clear ();
+	}
 	auto status (mdb_drop (transaction_a, unchecked, 0));
 	assert (status == 0);
 }
 
-void rai::block_store::unchecked_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, std::shared_ptr<rai::block> const & block_a)
+bool rai::block_store::unchecked_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, std::shared_ptr<rai::block> const & block_a)
 {
-	// Checking if same unchecked block is already in database
-	bool exists (false);
-	auto block_hash (block_a->hash ());
-	auto cached (unchecked_get (transaction_a, hash_a));
-	for (auto i (cached.begin ()), n (cached.end ()); i != n && !exists; ++i)
+	rai::unchecked_key key (hash_a, block_a->hash ());
+	auto result (false);
+	if (!unchecked_exists (transaction_a, key))
 	{
-		if ((*i)->hash () == block_hash)
+		result = unchecked_count (transaction_a) >= unchecked_max;
+		if (!result)
 		{
-			exists = true;
+			rai::unchecked_info info (block_a, rai::seconds_since_epoch ());
+			std::unique_lock<std::mutex> lock (cache_mutex);
+			if (unchecked_cache.size () < unchecked_cache_max)
+			{
+				unchecked_cache[key] = info;
+			}
+			else
+			{
+				lock.unlock ();
+				auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (key), rai::mdb_val (info), 0));
+				assert (status == 0);
+			}
 		}
 	}
-	// Inserting block if it wasn't found in database
-	if (!exists)
+	return result;
+}
+
+bool rai::block_store::unchecked_exists (MDB_txn * transaction_a, rai::unchecked_key const & key_a)
+{
+	auto result (false);
 	{
 		std::lock_guard<std::mutex> lock (cache_mutex);
-		unchecked_cache.insert (std::make_pair (hash_a, block_a));
+		result = unchecked_cache.find (key_a) != unchecked_cache.end ();
+	}
+	if (!result)
+	{
+		rai::mdb_val value;
+		auto status (mdb_get (transaction_a, unchecked, rai::mdb_val (key_a), value));
+		assert (status == 0 || status == MDB_NOTFOUND);
+		result = status == 0;
 	}
+	return result;
 }
 
 std::shared_ptr<rai::vote> rai::block_store::vote_get (MDB_txn * transaction_a, rai::account const & account_a)
@@ -1573,39 +1891,34 @@ std::shared_ptr<rai::vote> rai::block_store::vote_get (MDB_txn * transaction_a,
 std::vector<std::shared_ptr<rai::block>> rai::block_store::unchecked_get (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
 	std::vector<std::shared_ptr<rai::block>> result;
+	rai::unchecked_key start (hash_a, 0);
 	{
 		std::lock_guard<std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a; ++i)
+		for (auto i (unchecked_cache.lower_bound (start)), n (unchecked_cache.end ()); i != n && i->first.previous == hash_a; ++i)
 		{
-			result.push_back (i->second);
+			result.push_back (i->second.block);
 		}
 	}
-	for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && rai::block_hash (i->first) == hash_a; i.impl->next_dup ())
+	for (auto i (unchecked_begin (transaction_a, start)), n (unchecked_end ()); i != n && rai::unchecked_key (i->first).previous == hash_a; ++i)
 	{
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-		result.push_back (rai::deserialize_block (stream));
+		rai::unchecked_info info (i->second);
+		result.push_back (info.block);
 	}
 	return result;
 }
 
 void rai::block_store::unchecked_del (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a)
+{
+	unchecked_del (transaction_a, rai::unchecked_key (hash_a, block_a.hash ()));
+}
+
+void rai::block_store::unchecked_del (MDB_txn * transaction_a, rai::unchecked_key const & key_a)
 {
 	{
 		std::lock_guard<std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a;)
-		{
-			if (*i->second == block_a)
-			{
-				i = unchecked_cache.erase (i);
-			}
-			else
-			{
-				++i;
-			}
-		}
+		unchecked_cache.erase (key_a);
 	}
-	rai::mdb_val block (block_a);
-	auto status (mdb_del (transaction_a, unchecked, rai::mdb_val (hash_a), block));
+	auto status (mdb_del (transaction_a, unchecked, rai::mdb_val (key_a), nullptr));
 	assert (status == 0 || status == MDB_NOTFOUND);
 }
 
@@ -1614,7 +1927,9 @@ size_t rai::block_store::unchecked_count (MDB_txn * transaction_a)
 	MDB_stat unchecked_stats;
 	auto status (mdb_stat (transaction_a, unchecked, &unchecked_stats));
 	assert (status == 0);
-	auto result (unchecked_stats.ms_entries);
+	size_t result (unchecked_stats.ms_entries);
+	std::lock_guard<std::mutex> lock (cache_mutex);
+	result += unchecked_cache.size ();
 	return result;
 }
 
@@ -1659,7 +1974,7 @@ void rai::block_store::checksum_del (MDB_txn * transaction_a, uint64_t prefix, u
 void rai::block_store::flush (MDB_txn * transaction_a)
 {
 	std::unordered_map<rai::account, std::shared_ptr<rai::vote>> sequence_cache_l;
-	std::unordered_multimap<rai::block_hash, std::shared_ptr<rai::block>> unchecked_cache_l;
+	std::map<rai::unchecked_key, rai::unchecked_info> unchecked_cache_l;
 	{
 		std::lock_guard<std::mutex> lock (cache_mutex);
 		sequence_cache_l.swap (vote_cache);
@@ -1667,8 +1982,7 @@ void rai::block_store::flush (MDB_txn * transaction_a)
 	}
 	for (auto & i : unchecked_cache_l)
 	{
-		mdb_val block (*i.second);
-		auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (i.first), block, 0));
+		auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (i.first), rai::mdb_val (i.second), 0));
 		assert (status == 0);
 	}
 	for (auto i (sequence_cache_l.begin ()), n (sequence_cache_l.end ()); i != n; ++i)
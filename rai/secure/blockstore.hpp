@@ -3,6 +3,9 @@
 #include <rai/node/lmdb.hpp>
 #include <rai/secure/common.hpp>
 
+#include <atomic>
+#include <thread>
+
 namespace rai
 {
 class block_store;
@@ -76,6 +79,44 @@ public:
 	std::pair<rai::mdb_val, rai::mdb_val> current2;
 };
 
+/**
+ * Cuckoo filter over block hashes, answers that a hash was never stored without reading the database.
+ * False positives are possible, false negatives are not. Entries can be erased so rollbacks keep it tight.
+ * One writer at a time, readers never lock and retry if a write moved fingerprints while they looked.
+ */
+class block_filter
+{
+public:
+	block_filter (size_t);
+	// Returns true if the filter is full and the hash was not added
+	bool insert (rai::block_hash const &);
+	// Hash must have been inserted
+	void erase (rai::block_hash const &);
+	bool may_contain (rai::block_hash const &) const;
+	size_t size () const;
+	// Number of fingerprint slots
+	size_t capacity () const;
+	static size_t constexpr bucket_size = 4;
+	static size_t constexpr max_kicks = 512;
+
+private:
+	uint16_t fingerprint (rai::block_hash const &) const;
+	size_t index (rai::block_hash const &) const;
+	size_t alternate (size_t, uint16_t) const;
+	bool bucket_insert (size_t, uint16_t);
+	bool bucket_erase (size_t, uint16_t);
+	bool bucket_contains (size_t, uint16_t) const;
+	size_t mask;
+	size_t count;
+	// Odd while a write is in progress, bumped twice per write
+	std::atomic<uint64_t> sequence;
+	// Fingerprint and bucket that could not be placed after max_kicks, the filter is full while it is used
+	std::atomic<uint16_t> victim;
+	std::atomic<size_t> victim_index;
+	// bucket_size fingerprints per bucket, zero marks an empty slot
+	std::vector<std::atomic<uint16_t>> table;
+};
+
 /**
  * Manages block storage and iteration
  */
@@ -84,18 +125,25 @@ class block_store
 	friend class rai::block_predecessor_set;
 
 public:
-	block_store (bool &, boost::filesystem::path const &, int lmdb_max_dbs = 128);
+	block_store (bool &, boost::filesystem::path const &, int lmdb_max_dbs = 128, bool durable = true);
 
 	void initialize (MDB_txn *, rai::genesis const &);
-	void block_put (MDB_txn *, rai::block_hash const &, rai::block const &, rai::block_hash const & = rai::block_hash (0), rai::epoch version = rai::epoch::epoch_0);
+	void block_put (MDB_txn *, rai::block_hash const &, rai::block const &, rai::block_sideband const & = rai::block_sideband (), rai::epoch version = rai::epoch::epoch_0);
 	rai::block_hash block_successor (MDB_txn *, rai::block_hash const &);
 	void block_successor_clear (MDB_txn *, rai::block_hash const &);
-	std::unique_ptr<rai::block> block_get (MDB_txn *, rai::block_hash const &);
+	std::unique_ptr<rai::block> block_get (MDB_txn *, rai::block_hash const &, rai::block_sideband * = nullptr);
+	// Returns true if the block is missing or was stored without sideband
+	bool block_sideband_get (MDB_txn *, rai::block_hash const &, rai::block_sideband &);
 	std::unique_ptr<rai::block> block_random (MDB_txn *);
 	void block_del (MDB_txn *, rai::block_hash const &);
 	bool block_exists (MDB_txn *, rai::block_hash const &);
 	rai::block_counts block_count (MDB_txn *);
 	bool root_exists (MDB_txn *, rai::uint256_union const &);
+	rai::store_iterator block_begin (MDB_txn *, rai::block_hash const &);
+	rai::store_iterator block_end ();
+	// Seeks to the account's block at height, callers stop once the key's account differs
+	rai::store_iterator heights_begin (MDB_txn *, rai::account const &, uint64_t);
+	rai::store_iterator heights_end ();
 
 	void frontier_put (MDB_txn *, rai::block_hash const &, rai::account const &);
 	rai::account frontier_get (MDB_txn *, rai::block_hash const &);
@@ -130,16 +178,10 @@ public:
 	rai::store_merge_iterator pending_begin (MDB_txn *);
 	rai::store_merge_iterator pending_end ();
 
-	void block_info_put (MDB_txn *, rai::block_hash const &, rai::block_info const &);
-	void block_info_del (MDB_txn *, rai::block_hash const &);
-	bool block_info_get (MDB_txn *, rai::block_hash const &, rai::block_info &);
-	bool block_info_exists (MDB_txn *, rai::block_hash const &);
-	rai::store_iterator block_info_begin (MDB_txn *, rai::block_hash const &);
-	rai::store_iterator block_info_begin (MDB_txn *);
-	rai::store_iterator block_info_end ();
 	rai::uint128_t block_balance (MDB_txn *, rai::block_hash const &);
 	rai::epoch block_version (MDB_txn *, rai::block_hash const &);
-	static size_t const block_info_max = 32;
+	// Type and epoch bytes stored in front of each serialized block
+	static size_t const block_prefix_size = 2;
 
 	rai::uint128_t representation_get (MDB_txn *, rai::account const &);
 	void representation_put (MDB_txn *, rai::account const &, rai::uint128_t const &);
@@ -147,15 +189,42 @@ public:
 	rai::store_iterator representation_begin (MDB_txn *);
 	rai::store_iterator representation_end ();
 
+	void delegator_put (MDB_txn *, rai::account const &, rai::account const &);
+	void delegator_del (MDB_txn *, rai::account const &, rai::account const &);
+	// Seeks to the representative's delegators from start onwards, callers stop once the key's representative differs
+	rai::store_iterator delegators_begin (MDB_txn *, rai::account const &, rai::account const & = rai::account (0));
+	rai::store_iterator delegators_end ();
+	// In-memory copy of the committed representation table, weight lookups are served from here without touching the database
+	// Replaced whole when a transaction commits, readers load the pointer atomically and never lock
+	std::shared_ptr<std::unordered_map<rai::account, rai::uint128_t> const> representation_cache;
+	// Weights written by the open write transaction and its children, only visible through them until commit
+	// LMDB allows one writer at a time, only staged_writer's thread touches this or block_count_staged
+	std::unordered_map<MDB_txn *, std::unordered_map<rai::account, rai::uint128_t>> representation_staged;
+	// Thread holding the write transaction with staged weights or block counts
+	std::atomic<std::thread::id> staged_writer;
+	// Moves a committing transaction's weights into its parent or, for top level transactions, into representation_cache
+	void representation_commit (MDB_txn *, MDB_txn *);
+
 	void unchecked_clear (MDB_txn *);
-	void unchecked_put (MDB_txn *, rai::block_hash const &, std::shared_ptr<rai::block> const &);
+	// Returns true if the block was not stored because the unchecked table already holds unchecked_max entries
+	bool unchecked_put (MDB_txn *, rai::block_hash const &, std::shared_ptr<rai::block> const &);
 	std::vector<std::shared_ptr<rai::block>> unchecked_get (MDB_txn *, rai::block_hash const &);
+	bool unchecked_exists (MDB_txn *, rai::unchecked_key const &);
 	void unchecked_del (MDB_txn *, rai::block_hash const &, rai::block const &);
+	void unchecked_del (MDB_txn *, rai::unchecked_key const &);
 	rai::store_iterator unchecked_begin (MDB_txn *);
-	rai::store_iterator unchecked_begin (MDB_txn *, rai::block_hash const &);
+	rai::store_iterator unchecked_begin (MDB_txn *, rai::unchecked_key const &);
 	rai::store_iterator unchecked_end ();
+	// Entries on disk plus entries waiting in the cache, read from the table statistics rather than counted
 	size_t unchecked_count (MDB_txn *);
-	std::unordered_multimap<rai::block_hash, std::shared_ptr<rai::block>> unchecked_cache;
+	// Entries written since the last flush, ordered like the table so lookups by dependency are a range
+	std::map<rai::unchecked_key, rai::unchecked_info> unchecked_cache;
+	// Once the cache holds this many entries new ones are written straight to the table
+	size_t unchecked_cache_max;
+	// Upper bound on entries in the table and cache together
+	size_t unchecked_max;
+	static size_t constexpr unchecked_cache_max_default = 64 * 1024;
+	static size_t constexpr unchecked_max_default = 4 * 1024 * 1024;
 
 	void checksum_put (MDB_txn *, uint64_t, uint8_t, rai::checksum const &);
 	bool checksum_get (MDB_txn *, uint64_t, uint8_t, rai::checksum &);
@@ -176,6 +245,12 @@ public:
 	std::mutex cache_mutex;
 	std::unordered_map<rai::account, std::shared_ptr<rai::vote>> vote_cache;
 
+	// Every hash in the blocks table, built after upgrades on startup and grown when full
+	// Only the write transaction changes it, readers load the pointer atomically and never lock
+	std::shared_ptr<rai::block_filter> filter;
+	// Capacity the startup filter is given on top of the stored blocks
+	static size_t constexpr filter_headroom = 1024 * 1024;
+
 	void version_put (MDB_txn *, int);
 	int version_get (MDB_txn *);
 	void do_upgrades (MDB_txn *);
@@ -190,6 +265,10 @@ public:
 	void upgrade_v9_to_v10 (MDB_txn *);
 	void upgrade_v10_to_v11 (MDB_txn *);
 	void upgrade_v11_to_v12 (MDB_txn *);
+	void upgrade_v12_to_v13 (MDB_txn *);
+	void upgrade_v13_to_v14 (MDB_txn *);
+	void upgrade_v14_to_v15 (MDB_txn *);
+	void upgrade_v15_to_v16 (MDB_txn *);
 
 	// Requires a write transaction
 	rai::raw_key get_node_id (MDB_txn *);
@@ -218,40 +297,16 @@ public:
 	MDB_dbi accounts_v1;
 
 	/**
-	 * Maps block hash to send block.
-	 * rai::block_hash -> rai::send_block
+	 * Maps block hash to block type, block epoch, block and sideband.
+	 * rai::block_hash -> rai::block_type, rai::epoch, rai::block, rai::block_sideband
 	 */
-	MDB_dbi send_blocks;
+	MDB_dbi blocks;
 
 	/**
-	 * Maps block hash to receive block.
-	 * rai::block_hash -> rai::receive_block
+	 * Blocks of each account chain by height, written and deleted together with the blocks table.
+	 * rai::account, uint64_t -> rai::block_hash
 	 */
-	MDB_dbi receive_blocks;
-
-	/**
-	 * Maps block hash to open block.
-	 * rai::block_hash -> rai::open_block
-	 */
-	MDB_dbi open_blocks;
-
-	/**
-	 * Maps block hash to change block.
-	 * rai::block_hash -> rai::change_block
-	 */
-	MDB_dbi change_blocks;
-
-	/**
-	 * Maps block hash to v0 state block.
-	 * rai::block_hash -> rai::state_block
-	 */
-	MDB_dbi state_blocks_v0;
-
-	/**
-	 * Maps block hash to v1 state block.
-	 * rai::block_hash -> rai::state_block
-	 */
-	MDB_dbi state_blocks_v1;
+	MDB_dbi heights;
 
 	/**
 	 * Maps min_version 0 (destination account, pending block) to (source account, amount).
@@ -265,12 +320,6 @@ public:
 	 */
 	MDB_dbi pending_v1;
 
-	/**
-	 * Maps block hash to account and balance.
-	 * block_hash -> rai::account, rai::amount
-	 */
-	MDB_dbi blocks_info;
-
 	/**
 	 * Representative weights.
 	 * rai::account -> rai::uint128_t
@@ -278,8 +327,14 @@ public:
 	MDB_dbi representation;
 
 	/**
-	 * Unchecked bootstrap blocks.
-	 * rai::block_hash -> rai::block
+	 * Accounts by the representative they delegate to, maintained by the ledger.
+	 * rai::account, rai::account -> nothing
+	 */
+	MDB_dbi delegators;
+
+	/**
+	 * Unchecked bootstrap blocks keyed by the dependency they are waiting for.
+	 * rai::block_hash, rai::block_hash -> rai::block, uint64_t
 	 */
 	MDB_dbi unchecked;
 
@@ -296,16 +351,23 @@ public:
 	MDB_dbi vote;
 
 	/**
-	 * Meta information about block store, such as versions.
+	 * Meta information about block store, such as versions and block counts.
 	 * rai::uint256_union (arbitrary key) -> blob
 	 */
 	MDB_dbi meta;
 
 private:
-	MDB_dbi block_database (rai::block_type, rai::epoch);
-	std::unique_ptr<rai::block> block_random (MDB_txn *, MDB_dbi);
 	MDB_val block_raw_get (MDB_txn *, rai::block_hash const &, rai::block_type &);
-	void block_raw_put (MDB_txn *, MDB_dbi, rai::block_hash const &, MDB_val);
+	void block_raw_put (MDB_txn *, rai::block_hash const &, MDB_val);
+	void block_successor_set (MDB_txn *, rai::block_hash const &, rai::block_hash const &);
+	static size_t block_size (rai::block_type);
+	void block_count_add (MDB_txn *, rai::block_type, rai::epoch, int64_t);
+	// Count changes of the open write transaction, written to meta once when it commits
+	std::unordered_map<MDB_txn *, rai::block_counts> block_count_staged;
+	void block_count_commit (MDB_txn *, MDB_txn *);
+	void block_tables_merge (MDB_txn *);
+	// Filter holding every hash in the blocks table
+	std::shared_ptr<rai::block_filter> filter_build (MDB_txn *, size_t);
 	void clear (MDB_dbi);
 };
 }
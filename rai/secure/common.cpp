@@ -5,6 +5,7 @@
 #include <rai/secure/blockstore.hpp>
 #include <rai/secure/versioning.hpp>
 
+#include <boost/endian/conversion.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 #include <queue>
@@ -230,6 +231,46 @@ size_t rai::block_counts::sum ()
 	return send + receive + open + change + state_v0 + state_v1;
 }
 
+void rai::block_counts::add (rai::block_counts const & other_a)
+{
+	send += other_a.send;
+	receive += other_a.receive;
+	open += other_a.open;
+	change += other_a.change;
+	state_v0 += other_a.state_v0;
+	state_v1 += other_a.state_v1;
+}
+
+void rai::block_counts::serialize (rai::stream & stream_a) const
+{
+	rai::write (stream_a, static_cast<uint64_t> (send));
+	rai::write (stream_a, static_cast<uint64_t> (receive));
+	rai::write (stream_a, static_cast<uint64_t> (open));
+	rai::write (stream_a, static_cast<uint64_t> (change));
+	rai::write (stream_a, static_cast<uint64_t> (state_v0));
+	rai::write (stream_a, static_cast<uint64_t> (state_v1));
+}
+
+bool rai::block_counts::deserialize (rai::stream & stream_a)
+{
+	std::array<uint64_t, 6> counts;
+	auto error (false);
+	for (auto i (counts.begin ()), n (counts.end ()); i != n && !error; ++i)
+	{
+		error = rai::read (stream_a, *i);
+	}
+	if (!error)
+	{
+		send = counts[0];
+		receive = counts[1];
+		open = counts[2];
+		change = counts[3];
+		state_v0 = counts[4];
+		state_v1 = counts[5];
+	}
+	return error;
+}
+
 rai::pending_info::pending_info () :
 source (0),
 amount (0),
@@ -298,37 +339,176 @@ bool rai::pending_key::operator== (rai::pending_key const & other_a) const
 	return account == other_a.account && hash == other_a.hash;
 }
 
-rai::block_info::block_info () :
+rai::delegator_key::delegator_key () :
+representative (0),
+account (0)
+{
+}
+
+rai::delegator_key::delegator_key (rai::account const & representative_a, rai::account const & account_a) :
+representative (representative_a),
+account (account_a)
+{
+}
+
+bool rai::delegator_key::operator== (rai::delegator_key const & other_a) const
+{
+	return representative == other_a.representative && account == other_a.account;
+}
+
+rai::height_key::height_key () :
 account (0),
-balance (0)
+height (0)
+{
+}
+
+rai::height_key::height_key (rai::account const & account_a, uint64_t height_a) :
+account (account_a),
+height (height_a)
+{
+}
+
+void rai::height_key::serialize (rai::stream & stream_a) const
+{
+	rai::write (stream_a, account.bytes);
+	rai::write (stream_a, boost::endian::native_to_big (height));
+}
+
+bool rai::height_key::deserialize (rai::stream & stream_a)
+{
+	auto error (rai::read (stream_a, account.bytes));
+	if (!error)
+	{
+		error = rai::read (stream_a, height);
+		boost::endian::big_to_native_inplace (height);
+	}
+	return error;
+}
+
+bool rai::height_key::operator== (rai::height_key const & other_a) const
+{
+	return account == other_a.account && height == other_a.height;
+}
+
+rai::unchecked_key::unchecked_key () :
+previous (0),
+hash (0)
+{
+}
+
+rai::unchecked_key::unchecked_key (rai::block_hash const & previous_a, rai::block_hash const & hash_a) :
+previous (previous_a),
+hash (hash_a)
+{
+}
+
+void rai::unchecked_key::serialize (rai::stream & stream_a) const
+{
+	rai::write (stream_a, previous.bytes);
+	rai::write (stream_a, hash.bytes);
+}
+
+bool rai::unchecked_key::deserialize (rai::stream & stream_a)
+{
+	auto error (rai::read (stream_a, previous.bytes));
+	if (!error)
+	{
+		error = rai::read (stream_a, hash.bytes);
+	}
+	return error;
+}
+
+bool rai::unchecked_key::operator== (rai::unchecked_key const & other_a) const
+{
+	return previous == other_a.previous && hash == other_a.hash;
+}
+
+bool rai::unchecked_key::operator< (rai::unchecked_key const & other_a) const
+{
+	return previous == other_a.previous ? hash < other_a.hash : previous < other_a.previous;
+}
+
+rai::unchecked_info::unchecked_info () :
+modified (0)
+{
+}
+
+rai::unchecked_info::unchecked_info (std::shared_ptr<rai::block> block_a, uint64_t modified_a) :
+block (block_a),
+modified (modified_a)
+{
+}
+
+void rai::unchecked_info::serialize (rai::stream & stream_a) const
+{
+	assert (block != nullptr);
+	rai::serialize_block (stream_a, *block);
+	rai::write (stream_a, modified);
+}
+
+bool rai::unchecked_info::deserialize (rai::stream & stream_a)
+{
+	block = rai::deserialize_block (stream_a);
+	auto error (block == nullptr);
+	if (!error)
+	{
+		error = rai::read (stream_a, modified);
+	}
+	return error;
+}
+
+rai::block_sideband::block_sideband () :
+account (0),
+successor (0),
+balance (0),
+height (0),
+timestamp (0)
 {
 }
 
-rai::block_info::block_info (rai::account const & account_a, rai::amount const & balance_a) :
+rai::block_sideband::block_sideband (rai::account const & account_a, rai::block_hash const & successor_a, rai::amount const & balance_a, uint64_t height_a, uint64_t timestamp_a) :
 account (account_a),
-balance (balance_a)
+successor (successor_a),
+balance (balance_a),
+height (height_a),
+timestamp (timestamp_a)
 {
 }
 
-void rai::block_info::serialize (rai::stream & stream_a) const
+void rai::block_sideband::serialize (rai::stream & stream_a) const
 {
 	rai::write (stream_a, account.bytes);
 	rai::write (stream_a, balance.bytes);
+	rai::write (stream_a, height);
+	rai::write (stream_a, timestamp);
+	rai::write (stream_a, successor.bytes);
 }
 
-bool rai::block_info::deserialize (rai::stream & stream_a)
+bool rai::block_sideband::deserialize (rai::stream & stream_a)
 {
 	auto error (rai::read (stream_a, account.bytes));
 	if (!error)
 	{
 		error = rai::read (stream_a, balance.bytes);
+		if (!error)
+		{
+			error = rai::read (stream_a, height);
+			if (!error)
+			{
+				error = rai::read (stream_a, timestamp);
+				if (!error)
+				{
+					error = rai::read (stream_a, successor.bytes);
+				}
+			}
+		}
 	}
 	return error;
 }
 
-bool rai::block_info::operator== (rai::block_info const & other_a) const
+bool rai::block_sideband::operator== (rai::block_sideband const & other_a) const
 {
-	return account == other_a.account && balance == other_a.balance;
+	return account == other_a.account && successor == other_a.successor && balance == other_a.balance && height == other_a.height && timestamp == other_a.timestamp;
 }
 
 bool rai::vote::operator== (rai::vote const & other_a) const
@@ -497,17 +677,8 @@ void rai::balance_visitor::send_block (rai::send_block const & block_a)
 
 void rai::balance_visitor::receive_block (rai::receive_block const & block_a)
 {
-	rai::block_info block_info;
-	if (!store.block_info_get (transaction, block_a.hash (), block_info))
-	{
-		balance += block_info.balance.number ();
-		current_balance = 0;
-	}
-	else
-	{
-		current_amount = block_a.hashables.source;
-		current_balance = block_a.hashables.previous;
-	}
+	current_amount = block_a.hashables.source;
+	current_balance = block_a.hashables.previous;
 }
 
 void rai::balance_visitor::open_block (rai::open_block const & block_a)
@@ -518,16 +689,7 @@ void rai::balance_visitor::open_block (rai::open_block const & block_a)
 
 void rai::balance_visitor::change_block (rai::change_block const & block_a)
 {
-	rai::block_info block_info;
-	if (!store.block_info_get (transaction, block_a.hash (), block_info))
-	{
-		balance += block_info.balance.number ();
-		current_balance = 0;
-	}
-	else
-	{
-		current_balance = block_a.hashables.previous;
-	}
+	current_balance = block_a.hashables.previous;
 }
 
 void rai::balance_visitor::state_block (rai::state_block const & block_a)
@@ -550,9 +712,19 @@ void rai::balance_visitor::compute (rai::block_hash const & block_hash)
 		}
 		else
 		{
-			auto block (store.block_get (transaction, current_balance));
-			assert (block != nullptr);
-			block->visit (*this);
+			rai::block_sideband sideband;
+			if (!store.block_sideband_get (transaction, current_balance, sideband))
+			{
+				balance += sideband.balance.number ();
+				current_balance = 0;
+			}
+			else
+			{
+				// Only blocks stored before sideband existed need their chain walked
+				auto block (store.block_get (transaction, current_balance));
+				assert (block != nullptr);
+				block->visit (*this);
+			}
 		}
 	}
 }
@@ -613,7 +785,7 @@ rai::vote::vote (bool & error_a, rai::stream & stream_a)
 	error_a = deserialize (stream_a);
 }
 
-rai::vote::vote (bool & error_a, rai::stream & stream_a, rai::block_type type_a)
+rai::vote::vote (bool & error_a, rai::stream & stream_a, rai::block_type type_a, rai::block_uniquer * uniquer_a)
 {
 	if (!error_a)
 	{
@@ -639,7 +811,7 @@ rai::vote::vote (bool & error_a, rai::stream & stream_a, rai::block_type type_a)
 						}
 						else
 						{
-							std::shared_ptr<rai::block> block (rai::deserialize_block (stream_a, type_a));
+							auto block (rai::deserialize_block_shared (stream_a, type_a, uniquer_a));
 							error_a = block == nullptr;
 							if (!error_a)
 							{
@@ -794,7 +966,7 @@ bool rai::vote::deserialize (rai::stream & stream_a)
 						}
 						else
 						{
-							std::shared_ptr<rai::block> block (rai::deserialize_block (stream_a, type));
+							auto block (rai::deserialize_block_shared (stream_a, type));
 							result = block == nullptr;
 							if (!result)
 							{
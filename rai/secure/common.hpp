@@ -25,9 +25,11 @@ struct hash<rai::uint256_union>
 }
 namespace rai
 {
-const uint8_t protocol_version = 0x0d;
+const uint8_t protocol_version = 0x0e;
 const uint8_t protocol_version_min = 0x07;
 const uint8_t node_id_version = 0x0c;
+// Peers from this version answer confirm_req messages carrying hash and root pairs
+const uint8_t confirm_req_hashes_version = 0x0e;
 
 /**
  * A key pair. The private key is generated from the random pool, or passed in
@@ -104,22 +106,92 @@ public:
 	rai::account account;
 	rai::block_hash hash;
 };
-class block_info
+/**
+ * Key of the delegators index, accounts delegating to the same representative are adjacent
+ */
+class delegator_key
+{
+public:
+	delegator_key ();
+	delegator_key (rai::account const &, rai::account const &);
+	bool operator== (rai::delegator_key const &) const;
+	rai::account representative;
+	rai::account account;
+};
+/**
+ * Key of the heights index, an account's blocks are adjacent and ordered by height
+ */
+class height_key
+{
+public:
+	height_key ();
+	height_key (rai::account const &, uint64_t);
+	// Height is written big endian so keys sort numerically
+	void serialize (rai::stream &) const;
+	bool deserialize (rai::stream &);
+	bool operator== (rai::height_key const &) const;
+	rai::account account;
+	uint64_t height;
+};
+/**
+ * Information about a block's position in its account chain, stored with the block when it is inserted
+ */
+class block_sideband
 {
 public:
-	block_info ();
-	block_info (rai::account const &, rai::amount const &);
+	block_sideband ();
+	block_sideband (rai::account const &, rai::block_hash const &, rai::amount const &, uint64_t, uint64_t);
 	void serialize (rai::stream &) const;
 	bool deserialize (rai::stream &);
-	bool operator== (rai::block_info const &) const;
+	bool operator== (rai::block_sideband const &) const;
+	static size_t constexpr size = sizeof (rai::account) + sizeof (rai::amount) + sizeof (uint64_t) + sizeof (uint64_t) + sizeof (rai::block_hash);
 	rai::account account;
+	// Serialized last so it can be rewritten in place when the next block is added or rolled back
+	rai::block_hash successor;
 	rai::amount balance;
+	// Position in the account chain, the open block has height 1
+	uint64_t height;
+	// Seconds since epoch when the block was stored, zero if it was stored before sideband existed
+	uint64_t timestamp;
+};
+/**
+ * Key of an unchecked block, the dependency it is waiting for followed by its own hash.
+ * Entries waiting on the same dependency are adjacent so they can be found with a single seek.
+ */
+class unchecked_key
+{
+public:
+	unchecked_key ();
+	unchecked_key (rai::block_hash const &, rai::block_hash const &);
+	void serialize (rai::stream &) const;
+	bool deserialize (rai::stream &);
+	bool operator== (rai::unchecked_key const &) const;
+	bool operator< (rai::unchecked_key const &) const;
+	rai::block_hash previous;
+	rai::block_hash hash;
+};
+/**
+ * An unchecked block and the time it was put in the unchecked table
+ */
+class unchecked_info
+{
+public:
+	unchecked_info ();
+	unchecked_info (std::shared_ptr<rai::block>, uint64_t);
+	void serialize (rai::stream &) const;
+	bool deserialize (rai::stream &);
+	std::shared_ptr<rai::block> block;
+	// Seconds since epoch, entries older than the node's cutoff are removed
+	uint64_t modified;
 };
 class block_counts
 {
 public:
 	block_counts ();
 	size_t sum ();
+	void add (rai::block_counts const &);
+	void serialize (rai::stream &) const;
+	bool deserialize (rai::stream &);
 	size_t send;
 	size_t receive;
 	size_t open;
@@ -140,7 +212,7 @@ public:
 	vote () = default;
 	vote (rai::vote const &);
 	vote (bool &, rai::stream &);
-	vote (bool &, rai::stream &, rai::block_type);
+	vote (bool &, rai::stream &, rai::block_type, rai::block_uniquer * = nullptr);
 	vote (rai::account const &, rai::raw_key const &, uint64_t, std::shared_ptr<rai::block>);
 	vote (rai::account const &, rai::raw_key const &, uint64_t, std::vector<rai::block_hash>);
 	std::string hashes_string () const;
@@ -186,6 +258,11 @@ enum class process_result
 	representative_mismatch, // Representative is changed when it is not allowed
 	block_position // This block cannot follow the previous block
 };
+enum class signature_verification
+{
+	unknown, // Signature hasn't been checked, the ledger must validate it
+	valid // Signature was already checked against the block's own account
+};
 class process_return
 {
 public:
@@ -36,10 +36,6 @@ public:
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, pending.source);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
-		if (!(info.block_count % ledger.store.block_info_max))
-		{
-			ledger.store.block_info_del (transaction, hash);
-		}
 		ledger.stats.inc (rai::stat::type::rollback, rai::stat::detail::send);
 	}
 	void receive_block (rai::receive_block const & block_a) override
@@ -59,10 +55,6 @@ public:
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, destination_account);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
-		if (!(info.block_count % ledger.store.block_info_max))
-		{
-			ledger.store.block_info_del (transaction, hash);
-		}
 		ledger.stats.inc (rai::stat::type::rollback, rai::stat::detail::receive);
 	}
 	void open_block (rai::open_block const & block_a) override
@@ -89,15 +81,11 @@ public:
 		auto balance (ledger.balance (transaction, block_a.hashables.previous));
 		ledger.store.representation_add (transaction, representative, balance);
 		ledger.store.representation_add (transaction, hash, 0 - balance);
-		ledger.store.block_del (transaction, hash);
 		ledger.change_latest (transaction, account, block_a.hashables.previous, representative, info.balance, info.block_count - 1);
+		ledger.store.block_del (transaction, hash);
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, account);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
-		if (!(info.block_count % ledger.store.block_info_max))
-		{
-			ledger.store.block_info_del (transaction, hash);
-		}
 		ledger.stats.inc (rai::stat::type::rollback, rai::stat::detail::change);
 	}
 	void state_block (rai::state_block const & block_a) override
@@ -141,7 +129,7 @@ public:
 
 		assert (!error);
 		auto previous_version (ledger.store.block_version (transaction, block_a.hashables.previous));
-		ledger.change_latest (transaction, block_a.hashables.account, block_a.hashables.previous, representative, balance, info.block_count - 1, false, previous_version);
+		ledger.change_latest (transaction, block_a.hashables.account, block_a.hashables.previous, representative, balance, info.block_count - 1, previous_version);
 
 		auto previous (ledger.store.block_get (transaction, block_a.hashables.previous));
 		if (previous != nullptr)
@@ -165,7 +153,7 @@ public:
 class ledger_processor : public rai::block_visitor
 {
 public:
-	ledger_processor (rai::ledger &, MDB_txn *);
+	ledger_processor (rai::ledger &, MDB_txn *, rai::signature_verification = rai::signature_verification::unknown);
 	virtual ~ledger_processor () = default;
 	void send_block (rai::send_block const &) override;
 	void receive_block (rai::receive_block const &) override;
@@ -176,6 +164,7 @@ public:
 	void epoch_block_impl (rai::state_block const &);
 	rai::ledger & ledger;
 	MDB_txn * transaction;
+	rai::signature_verification verification;
 	rai::process_return result;
 };
 
@@ -212,7 +201,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 	result.code = existing ? rai::process_result::old : rai::process_result::progress; // Have we seen this block before? (Unambiguous)
 	if (result.code == rai::process_result::progress)
 	{
-		result.code = validate_message (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Unambiguous)
+		result.code = (verification != rai::signature_verification::valid && validate_message (block_a.hashables.account, hash, block_a.signature)) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Unambiguous)
 		if (result.code == rai::process_result::progress)
 		{
 			result.code = block_a.hashables.account.is_zero () ? rai::process_result::opened_burn_account : rai::process_result::progress; // Is this for the burn account? (Unambiguous)
@@ -278,7 +267,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 				{
 					ledger.stats.inc (rai::stat::type::ledger, rai::stat::detail::state_block);
 					result.state_is_send = is_send;
-					ledger.store.block_put (transaction, hash, block_a, 0, epoch);
+					ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (block_a.hashables.account, 0, block_a.hashables.balance, info.block_count + 1, rai::seconds_since_epoch ()), epoch);
 
 					if (!info.rep_block.is_zero ())
 					{
@@ -299,7 +288,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 						ledger.store.pending_del (transaction, rai::pending_key (block_a.hashables.account, block_a.hashables.link));
 					}
 
-					ledger.change_latest (transaction, block_a.hashables.account, hash, hash, block_a.hashables.balance, info.block_count + 1, true, epoch);
+					ledger.change_latest (transaction, block_a.hashables.account, hash, hash, block_a.hashables.balance, info.block_count + 1, epoch, &block_a.hashables.representative);
 					if (!ledger.store.frontier_get (transaction, info.head).is_zero ())
 					{
 						ledger.store.frontier_del (transaction, info.head);
@@ -361,8 +350,8 @@ void ledger_processor::epoch_block_impl (rai::state_block const & block_a)
 							ledger.stats.inc (rai::stat::type::ledger, rai::stat::detail::epoch_block);
 							result.account = block_a.hashables.account;
 							result.amount = 0;
-							ledger.store.block_put (transaction, hash, block_a, 0, rai::epoch::epoch_1);
-							ledger.change_latest (transaction, block_a.hashables.account, hash, hash, info.balance, info.block_count + 1, true, rai::epoch::epoch_1);
+							ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (block_a.hashables.account, 0, block_a.hashables.balance, info.block_count + 1, rai::seconds_since_epoch ()), rai::epoch::epoch_1);
+							ledger.change_latest (transaction, block_a.hashables.account, hash, hash, info.balance, info.block_count + 1, rai::epoch::epoch_1, &block_a.hashables.representative);
 							if (!ledger.store.frontier_get (transaction, info.head).is_zero ())
 							{
 								ledger.store.frontier_del (transaction, info.head);
@@ -397,14 +386,14 @@ void ledger_processor::change_block (rai::change_block const & block_a)
 					auto latest_error (ledger.store.account_get (transaction, account, info));
 					assert (!latest_error);
 					assert (info.head == block_a.hashables.previous);
-					result.code = validate_message (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
+					result.code = (verification != rai::signature_verification::valid && validate_message (account, hash, block_a.signature)) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
 					if (result.code == rai::process_result::progress)
 					{
-						ledger.store.block_put (transaction, hash, block_a);
+						ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (account, 0, info.balance, info.block_count + 1, rai::seconds_since_epoch ()));
 						auto balance (ledger.balance (transaction, block_a.hashables.previous));
 						ledger.store.representation_add (transaction, hash, balance);
 						ledger.store.representation_add (transaction, info.rep_block, 0 - balance);
-						ledger.change_latest (transaction, account, hash, hash, info.balance, info.block_count + 1);
+						ledger.change_latest (transaction, account, hash, hash, info.balance, info.block_count + 1, rai::epoch::epoch_0, &block_a.hashables.representative);
 						ledger.store.frontier_del (transaction, block_a.hashables.previous);
 						ledger.store.frontier_put (transaction, hash, account);
 						result.account = account;
@@ -435,7 +424,7 @@ void ledger_processor::send_block (rai::send_block const & block_a)
 				result.code = account.is_zero () ? rai::process_result::fork : rai::process_result::progress;
 				if (result.code == rai::process_result::progress)
 				{
-					result.code = validate_message (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
+					result.code = (verification != rai::signature_verification::valid && validate_message (account, hash, block_a.signature)) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
 					if (result.code == rai::process_result::progress)
 					{
 						rai::account_info info;
@@ -447,7 +436,7 @@ void ledger_processor::send_block (rai::send_block const & block_a)
 						{
 							auto amount (info.balance.number () - block_a.hashables.balance.number ());
 							ledger.store.representation_add (transaction, info.rep_block, 0 - amount);
-							ledger.store.block_put (transaction, hash, block_a);
+							ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (account, 0, block_a.hashables.balance, info.block_count + 1, rai::seconds_since_epoch ()));
 							ledger.change_latest (transaction, account, hash, info.rep_block, block_a.hashables.balance, info.block_count + 1);
 							ledger.store.pending_put (transaction, rai::pending_key (block_a.hashables.destination, hash), { account, amount, rai::epoch::epoch_0 });
 							ledger.store.frontier_del (transaction, block_a.hashables.previous);
@@ -485,7 +474,7 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
 					result.code = account.is_zero () ? rai::process_result::gap_previous : rai::process_result::progress; //Have we seen the previous block? No entries for account at all (Harmless)
 					if (result.code == rai::process_result::progress)
 					{
-						result.code = rai::validate_message (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
+						result.code = (verification != rai::signature_verification::valid && rai::validate_message (account, hash, block_a.signature)) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
 						if (result.code == rai::process_result::progress)
 						{
 							rai::account_info info;
@@ -506,7 +495,7 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
 										auto error (ledger.store.account_get (transaction, pending.source, source_info));
 										assert (!error);
 										ledger.store.pending_del (transaction, key);
-										ledger.store.block_put (transaction, hash, block_a);
+										ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (account, 0, new_balance, info.block_count + 1, rai::seconds_since_epoch ()));
 										ledger.change_latest (transaction, account, hash, info.rep_block, new_balance, info.block_count + 1);
 										ledger.store.representation_add (transaction, info.rep_block, pending.amount.number ());
 										ledger.store.frontier_del (transaction, block_a.hashables.previous);
@@ -540,7 +529,7 @@ void ledger_processor::open_block (rai::open_block const & block_a)
 		result.code = source_missing ? rai::process_result::gap_source : rai::process_result::progress; // Have we seen the source block? (Harmless)
 		if (result.code == rai::process_result::progress)
 		{
-			result.code = rai::validate_message (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
+			result.code = (verification != rai::signature_verification::valid && rai::validate_message (block_a.hashables.account, hash, block_a.signature)) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
 			if (result.code == rai::process_result::progress)
 			{
 				rai::account_info info;
@@ -562,8 +551,8 @@ void ledger_processor::open_block (rai::open_block const & block_a)
 								auto error (ledger.store.account_get (transaction, pending.source, source_info));
 								assert (!error);
 								ledger.store.pending_del (transaction, key);
-								ledger.store.block_put (transaction, hash, block_a);
-								ledger.change_latest (transaction, block_a.hashables.account, hash, hash, pending.amount.number (), info.block_count + 1);
+								ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (block_a.hashables.account, 0, pending.amount.number (), info.block_count + 1, rai::seconds_since_epoch ()));
+								ledger.change_latest (transaction, block_a.hashables.account, hash, hash, pending.amount.number (), info.block_count + 1, rai::epoch::epoch_0, &block_a.hashables.representative);
 								ledger.store.representation_add (transaction, hash, pending.amount.number ());
 								ledger.store.frontier_put (transaction, hash, block_a.hashables.account);
 								result.account = block_a.hashables.account;
@@ -578,9 +567,10 @@ void ledger_processor::open_block (rai::open_block const & block_a)
 	}
 }
 
-ledger_processor::ledger_processor (rai::ledger & ledger_a, MDB_txn * transaction_a) :
+ledger_processor::ledger_processor (rai::ledger & ledger_a, MDB_txn * transaction_a, rai::signature_verification verification_a) :
 ledger (ledger_a),
-transaction (transaction_a)
+transaction (transaction_a),
+verification (verification_a)
 {
 }
 } // namespace
@@ -644,9 +634,9 @@ rai::uint128_t rai::ledger::account_pending (MDB_txn * transaction_a, rai::accou
 	return result;
 }
 
-rai::process_return rai::ledger::process (MDB_txn * transaction_a, rai::block const & block_a)
+rai::process_return rai::ledger::process (MDB_txn * transaction_a, rai::block const & block_a, rai::signature_verification verification_a)
 {
-	ledger_processor processor (*this, transaction_a);
+	ledger_processor processor (*this, transaction_a, verification_a);
 	block_a.visit (processor);
 	return processor.result;
 }
@@ -776,29 +766,33 @@ rai::account rai::ledger::account (MDB_txn * transaction_a, rai::block_hash cons
 	rai::account result;
 	auto hash (hash_a);
 	rai::block_hash successor (1);
-	rai::block_info block_info;
+	rai::block_sideband sideband;
 	std::unique_ptr<rai::block> block (store.block_get (transaction_a, hash));
-	while (!successor.is_zero () && block->type () != rai::block_type::state && store.block_info_get (transaction_a, successor, block_info))
+	assert (block != nullptr);
+	// Blocks stored without sideband walk forward to one that has it, a state block or the frontier
+	auto missing (store.block_sideband_get (transaction_a, hash, sideband));
+	while (missing && !successor.is_zero () && block->type () != rai::block_type::state)
 	{
 		successor = store.block_successor (transaction_a, hash);
 		if (!successor.is_zero ())
 		{
 			hash = successor;
 			block = store.block_get (transaction_a, hash);
+			missing = store.block_sideband_get (transaction_a, hash, sideband);
 		}
 	}
-	if (block->type () == rai::block_type::state)
+	if (!missing)
 	{
-		auto state_block (dynamic_cast<rai::state_block *> (block.get ()));
-		result = state_block->hashables.account;
+		result = sideband.account;
 	}
-	else if (successor.is_zero ())
+	else if (block->type () == rai::block_type::state)
 	{
-		result = store.frontier_get (transaction_a, hash);
+		auto state_block (dynamic_cast<rai::state_block *> (block.get ()));
+		result = state_block->hashables.account;
 	}
 	else
 	{
-		result = block_info.account;
+		result = store.frontier_get (transaction_a, hash);
 	}
 	assert (!result.is_zero ());
 	return result;
@@ -913,7 +907,7 @@ void rai::ledger::checksum_update (MDB_txn * transaction_a, rai::block_hash cons
 	store.checksum_put (transaction_a, 0, 0, value);
 }
 
-void rai::ledger::change_latest (MDB_txn * transaction_a, rai::account const & account_a, rai::block_hash const & hash_a, rai::block_hash const & rep_block_a, rai::amount const & balance_a, uint64_t block_count_a, bool is_state, rai::epoch epoch_a)
+void rai::ledger::change_latest (MDB_txn * transaction_a, rai::account const & account_a, rai::block_hash const & hash_a, rai::block_hash const & rep_block_a, rai::amount const & balance_a, uint64_t block_count_a, rai::epoch epoch_a, rai::account const * representative_a)
 {
 	rai::account_info info;
 	auto exists (!store.account_get (transaction_a, account_a, info));
@@ -926,6 +920,32 @@ void rai::ledger::change_latest (MDB_txn * transaction_a, rai::account const & a
 		assert (store.block_get (transaction_a, hash_a)->previous ().is_zero ());
 		info.open_block = hash_a;
 	}
+	if (!exists || hash_a.is_zero () || info.rep_block != rep_block_a)
+	{
+		// Keep the delegators index in step, both representative blocks are still stored here during rollback
+		rai::account old_representative (0);
+		if (exists)
+		{
+			old_representative = store.block_get (transaction_a, info.rep_block)->representative ();
+		}
+		rai::account new_representative (0);
+		if (!hash_a.is_zero ())
+		{
+			// Blocks being processed pass their representative in, rollbacks look it up
+			new_representative = representative_a != nullptr ? *representative_a : store.block_get (transaction_a, rep_block_a)->representative ();
+		}
+		if (old_representative != new_representative)
+		{
+			if (exists)
+			{
+				store.delegator_del (transaction_a, old_representative, account_a);
+			}
+			if (!hash_a.is_zero ())
+			{
+				store.delegator_put (transaction_a, new_representative, account_a);
+			}
+		}
+	}
 	if (!hash_a.is_zero ())
 	{
 		info.head = hash_a;
@@ -940,13 +960,6 @@ void rai::ledger::change_latest (MDB_txn * transaction_a, rai::account const & a
 		}
 		info.epoch = epoch_a;
 		store.account_put (transaction_a, account_a, info);
-		if (!(block_count_a % store.block_info_max) && !is_state)
-		{
-			rai::block_info block_info;
-			block_info.account = account_a;
-			block_info.balance = balance_a;
-			store.block_info_put (transaction_a, hash_a, block_info);
-		}
 		checksum_update (transaction_a, hash_a);
 	}
 	else
@@ -198,13 +198,14 @@ TEST (node, fork_storm)
 		empty = 0;
 		single = 0;
 		std::for_each (system.nodes.begin (), system.nodes.end (), [&](std::shared_ptr<rai::node> const & node_a) {
-			if (node_a->active.roots.empty ())
+			if (node_a->active.empty ())
 			{
 				++empty;
 			}
 			else
 			{
-				if (node_a->active.roots.begin ()->election->last_votes.size () == 1)
+				auto election (node_a->active.election (node_a->active.list_blocks ().front ()->root ()));
+				if (election != nullptr && election->last_votes.size () == 1)
 				{
 					++single;
 				}